@@ -0,0 +1,88 @@
+//===- BumpPtrAllocator.cpp - BumpPtrAllocator benchmarks -----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "KeyDistributions.h"
+#include "benchmark/benchmark.h"
+#include "llvm/Support/Allocator.h"
+
+using namespace llvm;
+using namespace llvm::bench;
+
+// Object counts from a small function's MachineInstrs to a large module's
+// worth of IR.
+#define ALLOC_COUNTS RangeMultiplier(8)->Range(64, 1 << 18)
+
+static void BM_BumpPtrAllocateFixed(benchmark::State &State) {
+  unsigned N = State.range(0);
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    for (unsigned I = 0; I != N; ++I)
+      benchmark::DoNotOptimize(Alloc.Allocate<FakeValue>());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_BumpPtrAllocateFixed)->ALLOC_COUNTS;
+
+// Mixed sizes and alignments, like operand lists, names and nodes.
+static void BM_BumpPtrAllocateMixed(benchmark::State &State) {
+  std::vector<unsigned> Sizes = makeIntegerKeys(State.range(0));
+  for (unsigned &S : Sizes)
+    S = 8 + S % 120;
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    for (unsigned S : Sizes)
+      benchmark::DoNotOptimize(Alloc.Allocate(S, S % 16 == 0 ? 16 : 8));
+  }
+  State.SetItemsProcessed(State.iterations() * Sizes.size());
+}
+BENCHMARK(BM_BumpPtrAllocateMixed)->ALLOC_COUNTS;
+
+// Reusing one allocator through Reset(), as per-function codegen state does.
+static void BM_BumpPtrAllocateReset(benchmark::State &State) {
+  unsigned N = State.range(0);
+  BumpPtrAllocator Alloc;
+  for (auto _ : State) {
+    for (unsigned I = 0; I != N; ++I)
+      benchmark::DoNotOptimize(Alloc.Allocate<FakeValue>());
+    Alloc.Reset();
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_BumpPtrAllocateReset)->ALLOC_COUNTS;
+
+static void BM_BumpPtrAllocateLarge(benchmark::State &State) {
+  unsigned N = State.range(0) / 64;
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    // Larger than the slab size, so each one gets a custom-sized slab.
+    for (unsigned I = 0; I != N; ++I)
+      benchmark::DoNotOptimize(Alloc.Allocate(8192, 8));
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_BumpPtrAllocateLarge)->ALLOC_COUNTS;
+
+namespace {
+struct NonTrivial {
+  std::vector<unsigned> Data;
+};
+} // end anonymous namespace
+
+static void BM_SpecificBumpPtrAllocate(benchmark::State &State) {
+  unsigned N = State.range(0);
+  for (auto _ : State) {
+    // Includes the cost of running destructors on DestroyAll().
+    SpecificBumpPtrAllocator<NonTrivial> Alloc;
+    for (unsigned I = 0; I != N; ++I)
+      benchmark::DoNotOptimize(new (Alloc.Allocate()) NonTrivial());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SpecificBumpPtrAllocate)->ALLOC_COUNTS;
+
+BENCHMARK_MAIN();
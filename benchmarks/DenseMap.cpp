@@ -0,0 +1,199 @@
+//===- DenseMap.cpp - DenseMap and SmallPtrSet benchmarks -----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "KeyDistributions.h"
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
+
+using namespace llvm;
+using namespace llvm::bench;
+
+// Map sizes from a handful of values in a small function up to the value
+// numbering of a large module.
+#define MAP_SIZES RangeMultiplier(8)->Range(8, 1 << 18)
+
+static void BM_DenseMapInsertPointer(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  for (auto _ : State) {
+    DenseMap<FakeValue *, unsigned> Map;
+    for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+      Map.insert({Keys[I], I});
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapInsertPointer)->MAP_SIZES;
+
+static void BM_DenseMapInsertPointerReserved(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  for (auto _ : State) {
+    DenseMap<FakeValue *, unsigned> Map;
+    Map.reserve(Keys.size());
+    for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+      Map.insert({Keys[I], I});
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapInsertPointerReserved)->MAP_SIZES;
+
+static void BM_DenseMapLookupPointerHit(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  DenseMap<FakeValue *, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+    Map.insert({Keys[I], I});
+  // Look the keys up in a different order than they were inserted in.
+  auto Lookups = Keys;
+  std::shuffle(Lookups.begin(), Lookups.end(), std::mt19937(KeySeed + 1));
+  for (auto _ : State)
+    for (FakeValue *K : Lookups)
+      benchmark::DoNotOptimize(Map.find(K));
+  State.SetItemsProcessed(State.iterations() * Lookups.size());
+}
+BENCHMARK(BM_DenseMapLookupPointerHit)->MAP_SIZES;
+
+static void BM_DenseMapLookupPointerMiss(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  auto Misses = makePointerKeys(Alloc, State.range(0), KeySeed + 1);
+  DenseMap<FakeValue *, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+    Map.insert({Keys[I], I});
+  for (auto _ : State)
+    for (FakeValue *K : Misses)
+      benchmark::DoNotOptimize(Map.count(K));
+  State.SetItemsProcessed(State.iterations() * Misses.size());
+}
+BENCHMARK(BM_DenseMapLookupPointerMiss)->MAP_SIZES;
+
+static void BM_DenseMapLookupInteger(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  DenseMap<unsigned, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+    Map.insert({Keys[I], I});
+  for (auto _ : State)
+    for (unsigned K : Keys)
+      benchmark::DoNotOptimize(Map.lookup(K));
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapLookupInteger)->MAP_SIZES;
+
+static void BM_DenseMapEraseReinsert(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  DenseMap<FakeValue *, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+    Map.insert({Keys[I], I});
+  // Erasing leaves tombstones behind; re-inserting measures how well they are
+  // reused, as happens in maps that track a changing worklist.
+  for (auto _ : State) {
+    for (unsigned I = 0, E = Keys.size(); I < E; I += 2)
+      Map.erase(Keys[I]);
+    for (unsigned I = 0, E = Keys.size(); I < E; I += 2)
+      Map.insert({Keys[I], I});
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapEraseReinsert)->MAP_SIZES;
+
+static void BM_DenseMapIterate(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  DenseMap<FakeValue *, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+    Map.insert({Keys[I], I});
+  for (auto _ : State) {
+    unsigned Sum = 0;
+    for (const auto &KV : Map)
+      Sum += KV.second;
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapIterate)->MAP_SIZES;
+
+static void BM_DenseSetInsertPointer(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  for (auto _ : State) {
+    DenseSet<FakeValue *> Set;
+    for (FakeValue *K : Keys)
+      Set.insert(K);
+    benchmark::DoNotOptimize(Set);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseSetInsertPointer)->MAP_SIZES;
+
+//===----------------------------------------------------------------------===//
+// SmallPtrSet
+//===----------------------------------------------------------------------===//
+
+// Covers both the linear-scan small mode (N <= 8) and the hashed large mode.
+#define PTRSET_SIZES RangeMultiplier(4)->Range(4, 1 << 16)
+
+static void BM_SmallPtrSetInsert(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  for (auto _ : State) {
+    SmallPtrSet<FakeValue *, 8> Set;
+    for (FakeValue *K : Keys)
+      Set.insert(K);
+    benchmark::DoNotOptimize(Set);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallPtrSetInsert)->PTRSET_SIZES;
+
+static void BM_SmallPtrSetCount(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  auto Misses = makePointerKeys(Alloc, State.range(0), KeySeed + 1);
+  SmallPtrSet<FakeValue *, 8> Set(Keys.begin(), Keys.end());
+  for (auto _ : State) {
+    for (FakeValue *K : Keys)
+      benchmark::DoNotOptimize(Set.count(K));
+    for (FakeValue *K : Misses)
+      benchmark::DoNotOptimize(Set.count(K));
+  }
+  State.SetItemsProcessed(State.iterations() * 2 * Keys.size());
+}
+BENCHMARK(BM_SmallPtrSetCount)->PTRSET_SIZES;
+
+static void BM_SmallPtrSetErase(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  for (auto _ : State) {
+    State.PauseTiming();
+    SmallPtrSet<FakeValue *, 8> Set(Keys.begin(), Keys.end());
+    State.ResumeTiming();
+    for (FakeValue *K : Keys)
+      Set.erase(K);
+    benchmark::DoNotOptimize(Set);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallPtrSetErase)->PTRSET_SIZES;
+
+static void BM_SmallPtrSetIterate(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  SmallPtrSet<FakeValue *, 8> Set(Keys.begin(), Keys.end());
+  for (auto _ : State)
+    for (FakeValue *K : Set)
+      benchmark::DoNotOptimize(K);
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallPtrSetIterate)->PTRSET_SIZES;
+
+BENCHMARK_MAIN();
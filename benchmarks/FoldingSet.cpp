@@ -0,0 +1,97 @@
+//===- FoldingSet.cpp - FoldingSet benchmarks -----------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "KeyDistributions.h"
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/FoldingSet.h"
+
+using namespace llvm;
+using namespace llvm::bench;
+
+namespace {
+/// A node uniqued on an opcode and two operands, the way SDNodes, SCEVs and
+/// attribute lists are.
+struct Node : public FoldingSetNode {
+  unsigned Opcode;
+  FakeValue *LHS, *RHS;
+
+  Node(unsigned Opcode, FakeValue *LHS, FakeValue *RHS)
+      : Opcode(Opcode), LHS(LHS), RHS(RHS) {}
+
+  static void Profile(FoldingSetNodeID &ID, unsigned Opcode, FakeValue *LHS,
+                      FakeValue *RHS) {
+    ID.AddInteger(Opcode);
+    ID.AddPointer(LHS);
+    ID.AddPointer(RHS);
+  }
+  void Profile(FoldingSetNodeID &ID) const { Profile(ID, Opcode, LHS, RHS); }
+};
+} // end anonymous namespace
+
+static Node *getOrCreate(FoldingSet<Node> &Set, BumpPtrAllocator &Alloc,
+                         unsigned Opcode, FakeValue *LHS, FakeValue *RHS) {
+  FoldingSetNodeID ID;
+  Node::Profile(ID, Opcode, LHS, RHS);
+  void *InsertPos;
+  if (Node *N = Set.FindNodeOrInsertPos(ID, InsertPos))
+    return N;
+  Node *N = new (Alloc.Allocate<Node>()) Node(Opcode, LHS, RHS);
+  Set.InsertNode(N, InsertPos);
+  return N;
+}
+
+#define SET_SIZES RangeMultiplier(8)->Range(8, 1 << 17)
+
+static void BM_FoldingSetUniqueInsert(benchmark::State &State) {
+  BumpPtrAllocator KeyAlloc;
+  auto Keys = makePointerKeys(KeyAlloc, State.range(0) + 1);
+  for (auto _ : State) {
+    BumpPtrAllocator NodeAlloc;
+    FoldingSet<Node> Set;
+    for (unsigned I = 0, E = Keys.size() - 1; I != E; ++I)
+      benchmark::DoNotOptimize(
+          getOrCreate(Set, NodeAlloc, I % 16, Keys[I], Keys[I + 1]));
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_FoldingSetUniqueInsert)->SET_SIZES;
+
+static void BM_FoldingSetUniqueHit(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0) + 1);
+  FoldingSet<Node> Set;
+  for (unsigned I = 0, E = Keys.size() - 1; I != E; ++I)
+    getOrCreate(Set, Alloc, I % 16, Keys[I], Keys[I + 1]);
+  for (auto _ : State)
+    for (unsigned I = 0, E = Keys.size() - 1; I != E; ++I)
+      benchmark::DoNotOptimize(
+          getOrCreate(Set, Alloc, I % 16, Keys[I], Keys[I + 1]));
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_FoldingSetUniqueHit)->SET_SIZES;
+
+static void BM_FoldingSetRemove(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0) + 1);
+  FoldingSet<Node> Set;
+  std::vector<Node *> Nodes;
+  for (unsigned I = 0, E = Keys.size() - 1; I != E; ++I)
+    Nodes.push_back(getOrCreate(Set, Alloc, I % 16, Keys[I], Keys[I + 1]));
+  for (auto _ : State) {
+    for (Node *N : Nodes)
+      Set.RemoveNode(N);
+    State.PauseTiming();
+    for (Node *N : Nodes)
+      Set.InsertNode(N);
+    State.ResumeTiming();
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_FoldingSetRemove)->SET_SIZES;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,99 @@
+//===- IntervalMap.cpp - IntervalMap benchmarks ---------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "KeyDistributions.h"
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/IntervalMap.h"
+
+using namespace llvm;
+using namespace llvm::bench;
+
+// Same shape as the maps used by LiveDebugVariables and the register
+// allocator's LiveIntervalUnion: slot-index keyed, non-overlapping.
+typedef IntervalMap<unsigned, unsigned> MapT;
+
+#define MAP_SIZES RangeMultiplier(8)->Range(8, 1 << 16)
+
+static void BM_IntervalMapInsertSorted(benchmark::State &State) {
+  unsigned N = State.range(0);
+  for (auto _ : State) {
+    MapT::Allocator Alloc;
+    MapT Map(Alloc);
+    for (unsigned I = 0; I != N; ++I)
+      Map.insert(4 * I, 4 * I + 2, I);
+    benchmark::DoNotOptimize(Map.start());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_IntervalMapInsertSorted)->MAP_SIZES;
+
+static void BM_IntervalMapInsertRandom(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  for (auto _ : State) {
+    MapT::Allocator Alloc;
+    MapT Map(Alloc);
+    for (unsigned K : Keys)
+      Map.insert(4 * K, 4 * K + 2, K);
+    benchmark::DoNotOptimize(Map.start());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_IntervalMapInsertRandom)->MAP_SIZES;
+
+static void BM_IntervalMapLookup(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  MapT::Allocator Alloc;
+  MapT Map(Alloc);
+  for (unsigned K : Keys)
+    Map.insert(4 * K, 4 * K + 2, K);
+  // Half of the probes fall into the gaps between intervals.
+  for (auto _ : State)
+    for (unsigned K : Keys) {
+      benchmark::DoNotOptimize(Map.lookup(4 * K + 1));
+      benchmark::DoNotOptimize(Map.lookup(4 * K + 3));
+    }
+  State.SetItemsProcessed(State.iterations() * 2 * Keys.size());
+}
+BENCHMARK(BM_IntervalMapLookup)->MAP_SIZES;
+
+static void BM_IntervalMapIterate(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  MapT::Allocator Alloc;
+  MapT Map(Alloc);
+  for (unsigned K : Keys)
+    Map.insert(4 * K, 4 * K + 2, K);
+  for (auto _ : State) {
+    unsigned Sum = 0;
+    for (MapT::const_iterator I = Map.begin(); I.valid(); ++I)
+      Sum += I.value();
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_IntervalMapIterate)->MAP_SIZES;
+
+static void BM_IntervalMapErase(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  for (auto _ : State) {
+    State.PauseTiming();
+    MapT::Allocator Alloc;
+    MapT Map(Alloc);
+    for (unsigned K : Keys)
+      Map.insert(4 * K, 4 * K + 2, K);
+    State.ResumeTiming();
+    for (unsigned K : Keys) {
+      MapT::iterator I = Map.find(4 * K);
+      I.erase();
+    }
+    benchmark::DoNotOptimize(Map.empty());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_IntervalMapErase)->MAP_SIZES;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,87 @@
+//===- KeyDistributions.h - Key generators for ADT benchmarks ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Deterministic key generators shared by the ADT container benchmarks. The
+// distributions mimic what the compiler actually feeds into these containers:
+// pointers to IR objects, small dense integers (value numbers, register
+// numbers), and symbol names.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_BENCHMARKS_KEYDISTRIBUTIONS_H
+#define LLVM_BENCHMARKS_KEYDISTRIBUTIONS_H
+
+#include "llvm/Support/Allocator.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace llvm {
+namespace bench {
+
+/// Fixed seed, so that every run of a benchmark sees the same keys.
+static const unsigned KeySeed = 0x5eed;
+
+/// Roughly the size of an Instruction; keys produced by makePointerKeys are
+/// this far apart, just like Value* keys handed out by a BumpPtrAllocator.
+struct FakeValue {
+  char Storage[64];
+};
+
+/// Returns \p N distinct pointer keys in a pseudo-random order. The pointees
+/// are carved from \p Alloc, so the keys have the alignment and clustering of
+/// real Value* keys rather than being uniformly distributed.
+inline std::vector<FakeValue *> makePointerKeys(BumpPtrAllocator &Alloc,
+                                                size_t N,
+                                                unsigned Seed = KeySeed) {
+  std::vector<FakeValue *> Keys;
+  Keys.reserve(N);
+  for (size_t I = 0; I != N; ++I)
+    Keys.push_back(new (Alloc.Allocate<FakeValue>()) FakeValue());
+  std::shuffle(Keys.begin(), Keys.end(), std::mt19937(Seed));
+  return Keys;
+}
+
+/// Returns \p N distinct integer keys drawn from [0, 4 * N), in a
+/// pseudo-random order, like value or virtual register numbers.
+inline std::vector<unsigned> makeIntegerKeys(size_t N,
+                                             unsigned Seed = KeySeed) {
+  std::vector<unsigned> Keys(4 * N);
+  for (size_t I = 0; I != Keys.size(); ++I)
+    Keys[I] = I;
+  std::shuffle(Keys.begin(), Keys.end(), std::mt19937(Seed));
+  Keys.resize(N);
+  return Keys;
+}
+
+/// Returns \p N distinct Itanium-mangled-looking symbol names with a long
+/// shared prefix, in a pseudo-random order.
+inline std::vector<std::string> makeSymbolNames(size_t N,
+                                                unsigned Seed = KeySeed) {
+  static const char *const Namespaces[] = {"4llvm", "5clang", "3lld",
+                                           "4llvm6object", "4llvm3orc"};
+  std::mt19937 Gen(Seed);
+  std::vector<std::string> Names;
+  Names.reserve(N);
+  for (size_t I = 0; I != N; ++I) {
+    std::string Name = "_ZN";
+    Name += Namespaces[Gen() % 5];
+    std::string Ident = "Function" + std::to_string(I);
+    Name += std::to_string(Ident.size()) + Ident + "Ev";
+    Names.push_back(std::move(Name));
+  }
+  std::shuffle(Names.begin(), Names.end(), Gen);
+  return Names;
+}
+
+} // end namespace bench
+} // end namespace llvm
+
+#endif // LLVM_BENCHMARKS_KEYDISTRIBUTIONS_H
@@ -0,0 +1,113 @@
+//===- SmallVector.cpp - SmallVector benchmarks ---------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "KeyDistributions.h"
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallVector.h"
+
+using namespace llvm;
+using namespace llvm::bench;
+
+// From sizes that fit in the inline storage to sizes that have to grow the
+// heap buffer several times.
+#define VECTOR_SIZES RangeMultiplier(8)->Range(4, 1 << 16)
+
+static void BM_SmallVectorPushBackPointer(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  for (auto _ : State) {
+    SmallVector<FakeValue *, 8> Vec;
+    for (FakeValue *K : Keys)
+      Vec.push_back(K);
+    benchmark::DoNotOptimize(Vec.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallVectorPushBackPointer)->VECTOR_SIZES;
+
+static void BM_SmallVectorPushBackReserved(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  for (auto _ : State) {
+    SmallVector<FakeValue *, 8> Vec;
+    Vec.reserve(Keys.size());
+    for (FakeValue *K : Keys)
+      Vec.push_back(K);
+    benchmark::DoNotOptimize(Vec.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallVectorPushBackReserved)->VECTOR_SIZES;
+
+static void BM_SmallVectorAppendRange(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  for (auto _ : State) {
+    SmallVector<unsigned, 16> Vec;
+    Vec.append(Keys.begin(), Keys.end());
+    benchmark::DoNotOptimize(Vec.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallVectorAppendRange)->VECTOR_SIZES;
+
+// Worklist pattern: push a batch, pop everything, repeat with the same vector.
+static void BM_SmallVectorWorklist(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  auto Keys = makePointerKeys(Alloc, State.range(0));
+  SmallVector<FakeValue *, 16> Worklist;
+  for (auto _ : State) {
+    for (FakeValue *K : Keys)
+      Worklist.push_back(K);
+    while (!Worklist.empty())
+      benchmark::DoNotOptimize(Worklist.pop_back_val());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallVectorWorklist)->VECTOR_SIZES;
+
+static void BM_SmallVectorInsertFront(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  for (auto _ : State) {
+    SmallVector<unsigned, 8> Vec;
+    for (unsigned K : Keys)
+      Vec.insert(Vec.begin(), K);
+    benchmark::DoNotOptimize(Vec.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallVectorInsertFront)->RangeMultiplier(8)->Range(4, 1 << 12);
+
+static void BM_SmallVectorEraseIf(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  for (auto _ : State) {
+    State.PauseTiming();
+    SmallVector<unsigned, 8> Vec(Keys.begin(), Keys.end());
+    State.ResumeTiming();
+    Vec.erase(std::remove_if(Vec.begin(), Vec.end(),
+                             [](unsigned K) { return K & 1; }),
+              Vec.end());
+    benchmark::DoNotOptimize(Vec.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallVectorEraseIf)->VECTOR_SIZES;
+
+static void BM_SmallVectorIterate(benchmark::State &State) {
+  auto Keys = makeIntegerKeys(State.range(0));
+  SmallVector<unsigned, 8> Vec(Keys.begin(), Keys.end());
+  for (auto _ : State) {
+    unsigned Sum = 0;
+    for (unsigned K : Vec)
+      Sum += K;
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_SmallVectorIterate)->VECTOR_SIZES;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,128 @@
+//===- Startup.cpp - Option and pass registration benchmarks --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Measures the work a tool does before it reads its input: registering its
+// command-line options and parsing the command line, and registering passes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "benchmark/benchmark.h"
+#include "llvm/PassInfo.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// From a small tool up to llc with every target linked in.
+#define OPTION_COUNTS RangeMultiplier(4)->Range(64, 1 << 14)
+
+static std::vector<std::string> makeOptionNames(size_t N) {
+  std::vector<std::string> Names;
+  Names.reserve(N);
+  for (size_t I = 0; I != N; ++I)
+    Names.push_back("bench-option-" + std::to_string(I));
+  return Names;
+}
+
+static void BM_RegisterAndParseOptions(benchmark::State &State) {
+  auto Names = makeOptionNames(State.range(0));
+  // A typical command line names only a handful of the options.
+  std::vector<std::string> Args = {"bench"};
+  for (size_t I = 0, E = Names.size(); I < E; I += E / 8)
+    Args.push_back("-" + Names[I] + "=1");
+  std::vector<const char *> Argv;
+  for (const std::string &A : Args)
+    Argv.push_back(A.c_str());
+
+  for (auto _ : State) {
+    std::vector<std::unique_ptr<cl::opt<unsigned>>> Options;
+    Options.reserve(Names.size());
+    for (const std::string &Name : Names)
+      Options.emplace_back(
+          new cl::opt<unsigned>(StringRef(Name), cl::Hidden));
+    cl::ParseCommandLineOptions(Argv.size(), Argv.data());
+    for (auto &O : Options)
+      O->removeArgument();
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_RegisterAndParseOptions)->OPTION_COUNTS;
+
+//===----------------------------------------------------------------------===//
+// PassRegistry
+//===----------------------------------------------------------------------===//
+
+#define PASS_COUNTS RangeMultiplier(4)->Range(64, 1 << 12)
+
+static Pass *createNoPass() { return nullptr; }
+
+namespace {
+/// The passes of an imaginary library, and its initializer.
+struct BenchPasses {
+  std::vector<std::string> Names;
+  std::vector<char> IDs;
+  std::vector<std::unique_ptr<PassInfo>> Infos;
+
+  explicit BenchPasses(size_t N) : Names(makeOptionNames(N)), IDs(N) {
+    for (size_t I = 0; I != N; ++I)
+      Infos.emplace_back(new PassInfo(Names[I], Names[I], &IDs[I],
+                                      PassInfo::NormalCtor_t(createNoPass),
+                                      false, false));
+  }
+};
+} // end anonymous namespace
+
+static BenchPasses *CurrentPasses;
+
+static void initializeBenchPasses(PassRegistry &Registry) {
+  for (auto &PI : CurrentPasses->Infos)
+    Registry.registerPass(*PI);
+}
+
+static void BM_PassRegistryEager(benchmark::State &State) {
+  BenchPasses Passes(State.range(0));
+  CurrentPasses = &Passes;
+  for (auto _ : State) {
+    PassRegistry Registry;
+    initializeBenchPasses(Registry);
+    benchmark::DoNotOptimize(Registry.getPassInfo(&Passes.IDs[0]));
+  }
+  State.SetItemsProcessed(State.iterations() * Passes.Infos.size());
+}
+BENCHMARK(BM_PassRegistryEager)->PASS_COUNTS;
+
+// A tool that never runs any of the library's passes.
+static void BM_PassRegistryLazyUnused(benchmark::State &State) {
+  BenchPasses Passes(State.range(0));
+  CurrentPasses = &Passes;
+  for (auto _ : State) {
+    PassRegistry Registry;
+    Registry.registerLazyInitializer(initializeBenchPasses);
+    benchmark::DoNotOptimize(Registry);
+  }
+  State.SetItemsProcessed(State.iterations() * Passes.Infos.size());
+}
+BENCHMARK(BM_PassRegistryLazyUnused)->PASS_COUNTS;
+
+// A tool that looks up one of the library's passes, which registers them all.
+static void BM_PassRegistryLazyUsed(benchmark::State &State) {
+  BenchPasses Passes(State.range(0));
+  CurrentPasses = &Passes;
+  for (auto _ : State) {
+    PassRegistry Registry;
+    Registry.registerLazyInitializer(initializeBenchPasses);
+    benchmark::DoNotOptimize(Registry.getPassInfo(Passes.Names.back()));
+  }
+  State.SetItemsProcessed(State.iterations() * Passes.Infos.size());
+}
+BENCHMARK(BM_PassRegistryLazyUsed)->PASS_COUNTS;
+
+BENCHMARK_MAIN();
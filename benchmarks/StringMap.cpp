@@ -0,0 +1,139 @@
+//===- StringMap.cpp - StringMap benchmarks -------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "KeyDistributions.h"
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/StringMap.h"
+
+using namespace llvm;
+using namespace llvm::bench;
+
+// From a single object file's symbol table to a large link.
+#define MAP_SIZES RangeMultiplier(8)->Range(8, 1 << 18)
+
+static void BM_StringMapInsert(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  for (auto _ : State) {
+    StringMap<unsigned> Map;
+    for (unsigned I = 0, E = Names.size(); I != E; ++I)
+      Map.insert({Names[I], I});
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapInsert)->MAP_SIZES;
+
+static void BM_StringMapInsertAllocator(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  for (auto _ : State) {
+    StringMap<unsigned, BumpPtrAllocator> Map;
+    for (unsigned I = 0, E = Names.size(); I != E; ++I)
+      Map.insert({Names[I], I});
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapInsertAllocator)->MAP_SIZES;
+
+static void BM_StringMapLookupHit(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  StringMap<unsigned> Map;
+  for (unsigned I = 0, E = Names.size(); I != E; ++I)
+    Map.insert({Names[I], I});
+  auto Lookups = Names;
+  std::shuffle(Lookups.begin(), Lookups.end(), std::mt19937(KeySeed + 1));
+  for (auto _ : State)
+    for (const std::string &N : Lookups)
+      benchmark::DoNotOptimize(Map.find(N));
+  State.SetItemsProcessed(State.iterations() * Lookups.size());
+}
+BENCHMARK(BM_StringMapLookupHit)->MAP_SIZES;
+
+static void BM_StringMapLookupMiss(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  StringMap<unsigned> Map;
+  for (unsigned I = 0, E = Names.size(); I != E; ++I)
+    Map.insert({Names[I], I});
+  // Same shape and prefixes as the keys, but none of them is present.
+  std::vector<std::string> Misses;
+  for (const std::string &N : Names)
+    Misses.push_back(N + "_");
+  for (auto _ : State)
+    for (const std::string &N : Misses)
+      benchmark::DoNotOptimize(Map.count(N));
+  State.SetItemsProcessed(State.iterations() * Misses.size());
+}
+BENCHMARK(BM_StringMapLookupMiss)->MAP_SIZES;
+
+static void BM_StringMapEraseReinsert(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  StringMap<unsigned> Map;
+  for (unsigned I = 0, E = Names.size(); I != E; ++I)
+    Map.insert({Names[I], I});
+  for (auto _ : State) {
+    for (unsigned I = 0, E = Names.size(); I < E; I += 2)
+      Map.erase(Names[I]);
+    for (unsigned I = 0, E = Names.size(); I < E; I += 2)
+      Map.insert({Names[I], I});
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapEraseReinsert)->MAP_SIZES;
+
+static void BM_StringMapIterate(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  StringMap<unsigned> Map;
+  for (unsigned I = 0, E = Names.size(); I != E; ++I)
+    Map.insert({Names[I], I});
+  for (auto _ : State) {
+    size_t Sum = 0;
+    for (const auto &KV : Map)
+      Sum += KV.getKeyLength() + KV.getValue();
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapIterate)->MAP_SIZES;
+
+// Two tables keyed on the same names, as in MCContext's symbol tables: hashing
+// each name once and passing the hash to both lookups.
+static void
+BM_StringMapLookupTwoTablesPrecomputedHash(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  StringMap<unsigned> Map1, Map2;
+  for (unsigned I = 0, E = Names.size(); I != E; ++I) {
+    Map1.insert({Names[I], I});
+    Map2.insert({Names[I], I});
+  }
+  for (auto _ : State)
+    for (const std::string &N : Names) {
+      unsigned Hash = StringMapImpl::hash(N);
+      benchmark::DoNotOptimize(Map1.find(N, Hash));
+      benchmark::DoNotOptimize(Map2.find(N, Hash));
+    }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapLookupTwoTablesPrecomputedHash)->MAP_SIZES;
+
+static void BM_StringMapLookupTwoTables(benchmark::State &State) {
+  auto Names = makeSymbolNames(State.range(0));
+  StringMap<unsigned> Map1, Map2;
+  for (unsigned I = 0, E = Names.size(); I != E; ++I) {
+    Map1.insert({Names[I], I});
+    Map2.insert({Names[I], I});
+  }
+  for (auto _ : State)
+    for (const std::string &N : Names) {
+      benchmark::DoNotOptimize(Map1.find(N));
+      benchmark::DoNotOptimize(Map2.find(N));
+    }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapLookupTwoTables)->MAP_SIZES;
+
+BENCHMARK_MAIN();
@@ -20,6 +20,10 @@
 //
 // NOTE: Statistics *must* be declared as global variables.
 //
+// Increments go to per-thread shards of counters that are only summed up when
+// the value is read, so threads bumping the same statistic do not contend on
+// its cache line.
+//
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_ADT_STATISTIC_H
@@ -49,10 +53,18 @@ public:
   const char *DebugType;
   const char *Name;
   const char *Desc;
+  /// The part of the value that is not kept in the shards: the value last
+  /// assigned, or the maximum seen by updateMax.
   std::atomic<unsigned> Value;
   std::atomic<bool> Initialized;
-
-  unsigned getValue() const { return Value.load(std::memory_order_relaxed); }
+  /// The index of the counters of this statistic in the shards, assigned when
+  /// it is first registered. 0 if it has not been assigned yet.
+  std::atomic<unsigned> Id;
+
+  unsigned getValue() const;
+  /// Set the value, regardless of LLVM_ENABLE_STATS, and clear the counters
+  /// in all shards.
+  void setValue(unsigned Val);
   const char *getDebugType() const { return DebugType; }
   const char *getName() const { return Name; }
   const char *getDesc() const { return Desc; }
@@ -64,51 +76,54 @@ public:
     Desc = desc;
     Value = 0;
     Initialized = false;
+    Id = 0;
   }
 
   // Allow use of this class as the value itself.
   operator unsigned() const { return getValue(); }
 
 #if LLVM_ENABLE_STATS
-   const Statistic &operator=(unsigned Val) {
-    Value.store(Val, std::memory_order_relaxed);
-    return init();
+  const Statistic &operator=(unsigned Val) {
+    init().setValue(Val);
+    return *this;
   }
 
   const Statistic &operator++() {
-    Value.fetch_add(1, std::memory_order_relaxed);
-    return init();
+    init().getCounter().fetch_add(1, std::memory_order_relaxed);
+    return *this;
   }
 
-  unsigned operator++(int) {
-    init();
-    return Value.fetch_add(1, std::memory_order_relaxed);
+  /// The postfix operators return nothing, as the previous value of the
+  /// whole statistic is not known to any one thread.
+  void operator++(int) {
+    init().getCounter().fetch_add(1, std::memory_order_relaxed);
   }
 
   const Statistic &operator--() {
-    Value.fetch_sub(1, std::memory_order_relaxed);
-    return init();
+    init().getCounter().fetch_sub(1, std::memory_order_relaxed);
+    return *this;
   }
 
-  unsigned operator--(int) {
-    init();
-    return Value.fetch_sub(1, std::memory_order_relaxed);
+  void operator--(int) {
+    init().getCounter().fetch_sub(1, std::memory_order_relaxed);
   }
 
   const Statistic &operator+=(unsigned V) {
     if (V == 0)
       return *this;
-    Value.fetch_add(V, std::memory_order_relaxed);
-    return init();
+    init().getCounter().fetch_add(V, std::memory_order_relaxed);
+    return *this;
   }
 
   const Statistic &operator-=(unsigned V) {
     if (V == 0)
       return *this;
-    Value.fetch_sub(V, std::memory_order_relaxed);
-    return init();
+    init().getCounter().fetch_sub(V, std::memory_order_relaxed);
+    return *this;
   }
 
+  /// Statistics updated with updateMax are not sharded, and should not also
+  /// be incremented.
   void updateMax(unsigned V) {
     unsigned PrevMax = Value.load(std::memory_order_relaxed);
     // Keep trying to update max until we succeed or another thread produces
@@ -129,17 +144,13 @@ public:
     return *this;
   }
 
-  unsigned operator++(int) {
-    return 0;
-  }
+  void operator++(int) {}
 
   const Statistic &operator--() {
     return *this;
   }
 
-  unsigned operator--(int) {
-    return 0;
-  }
+  void operator--(int) {}
 
   const Statistic &operator+=(const unsigned &V) {
     return *this;
@@ -161,12 +172,15 @@ protected:
   }
 
   void RegisterStatistic();
+
+  /// Return the counter of this statistic in the current thread's shard.
+  std::atomic<unsigned> &getCounter();
 };
 
 // STATISTIC - A macro to make definition of statistics really simple.  This
 // automatically passes the DEBUG_TYPE of the file into the statistic.
 #define STATISTIC(VARNAME, DESC)                                               \
-  static llvm::Statistic VARNAME = {DEBUG_TYPE, #VARNAME, DESC, {0}, {false}}
+  static llvm::Statistic VARNAME = {DEBUG_TYPE, #VARNAME, DESC, {0}, {false}, {0}}
 
 /// Enable the collection and printing of statistics.
 void EnableStatistics(bool PrintOnExit = true);
@@ -213,6 +227,26 @@ const std::vector<std::pair<StringRef, unsigned>> GetStatistics();
 /// GetStatistics().
 void ResetStatistics();
 
+/// The values of the registered statistics at some point in time.
+using StatisticsSnapshot = std::vector<std::pair<const Statistic *, unsigned>>;
+
+/// Check if -stats-deltas was given, in which case pass managers record how
+/// the statistics change while they run on each module and function.
+bool AreStatisticsDeltasEnabled();
+
+/// Return the current values of the registered statistics.
+StatisticsSnapshot GetStatisticsSnapshot();
+
+/// Record the statistics that changed since \p Before as changes made while
+/// processing \p Function of \p Module, or the whole module if \p Function
+/// is empty. The recorded changes are written as JSON to the -stats-deltas
+/// file at exit.
+///
+/// As with ResetStatistics(), changes made by other threads in the meantime
+/// are included, so this is only exact if one compilation runs at a time.
+void RecordStatisticsDelta(StringRef Module, StringRef Function,
+                           const StatisticsSnapshot &Before);
+
 } // end namespace llvm
 
 #endif // LLVM_ADT_STATISTIC_H
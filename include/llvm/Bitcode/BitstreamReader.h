@@ -256,6 +256,37 @@ public:
     }
   }
 
+  /// Read \p NumElts VBR values of chunk width \p NumBits into \p Vals.
+  /// Values that fit in a single chunk are decoded straight out of the current
+  /// word, without going through Read for each one.
+  void ReadVBR64Array(unsigned NumBits, unsigned NumElts,
+                      SmallVectorImpl<uint64_t> &Vals) {
+    // A corrupt count must not turn into a huge allocation; every value takes
+    // at least one chunk.
+    size_t MaxElts = (BitcodeBytes.size() * CHAR_BIT - GetCurrentBitNo()) /
+                     NumBits;
+    Vals.reserve(Vals.size() + std::min<size_t>(NumElts, MaxElts));
+    // Shifting a word by its full width is undefined, so chunks as wide as a
+    // word, possible with 32-bit words, all go through ReadVBR64.
+    const bool FastPath = NumBits < MaxChunkSize;
+    const word_t ChunkMask = ~word_t(0) >> (MaxChunkSize - NumBits);
+    const word_t ContinueBit = word_t(1) << (NumBits - 1);
+    while (NumElts) {
+      for (; FastPath && NumElts && BitsInCurWord >= NumBits; --NumElts) {
+        word_t Piece = CurWord & ChunkMask;
+        if (Piece & ContinueBit)
+          break;
+        Vals.push_back(Piece);
+        CurWord >>= NumBits;
+        BitsInCurWord -= NumBits;
+      }
+      if (!NumElts)
+        break;
+      Vals.push_back(ReadVBR64(NumBits));
+      --NumElts;
+    }
+  }
+
   void SkipToFourByteBoundary() {
     // If word_t is 64-bits and if we've read less than 32 bits, just dump
     // the bits we have up to the next 32-bit boundary.
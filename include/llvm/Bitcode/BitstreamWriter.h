@@ -116,6 +116,16 @@ public:
     BackpatchWord(BitNo + 32, (uint32_t)(Val >> 32));
   }
 
+  /// Append complete blocks that were encoded by another BitstreamWriter. The
+  /// blocks must have been entered with the same abbrev ID width as is current
+  /// here, and both this stream and \p Bytes must be word-aligned; the result
+  /// is then identical to having emitted the blocks on this stream.
+  void AppendEncodedBlocks(ArrayRef<char> Bytes) {
+    assert(CurBit == 0 && "Stream is not word-aligned");
+    assert(Bytes.size() % 4 == 0 && "Blocks do not end at a word boundary");
+    Out.append(Bytes.begin(), Bytes.end());
+  }
+
   void Emit(uint32_t Val, unsigned NumBits) {
     assert(NumBits && NumBits <= 32 && "Invalid value size!");
     assert((Val & ~(~0U >> (32-NumBits))) == 0 && "High bits set!");
@@ -13,6 +13,9 @@
 #ifndef LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
 #define LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Object/ObjectFile.h"
@@ -39,6 +42,10 @@ public:
     bool UseSymbolTable : 1;
     bool Demangle : 1;
     bool RelativeAddresses : 1;
+    /// Keep the code symbolization results of each module until flush(), for
+    /// clients that ask for the same addresses over and over. The cache is
+    /// not bounded, so it is off by default.
+    bool CacheResults : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
 
@@ -47,7 +54,13 @@ public:
             bool RelativeAddresses = false, std::string DefaultArch = "")
         : PrintFunctions(PrintFunctions), UseSymbolTable(UseSymbolTable),
           Demangle(Demangle), RelativeAddresses(RelativeAddresses),
-          DefaultArch(std::move(DefaultArch)) {}
+          CacheResults(false), DefaultArch(std::move(DefaultArch)) {}
+  };
+
+  /// A code address to symbolize in a batch.
+  struct ModuleAddress {
+    StringRef ModuleName;
+    uint64_t ModuleOffset;
   };
 
   LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
@@ -64,6 +77,23 @@ public:
                                                 StringRef DWPName = "");
   Expected<DIGlobal> symbolizeData(const std::string &ModuleName,
                                    uint64_t ModuleOffset);
+
+  /// Symbolize each of \p Addresses as symbolizeCode would, returning the
+  /// results in the same order. The modules are loaded first. An error
+  /// loading one is passed to \p HandleLoadError, and the results for its
+  /// addresses are left empty. Each distinct offset in a module is resolved
+  /// once, and different modules are resolved on different threads.
+  std::vector<DILineInfo>
+  symbolizeCodeBatch(ArrayRef<ModuleAddress> Addresses,
+                     function_ref<void(Error)> HandleLoadError,
+                     StringRef DWPName = "");
+  /// Like symbolizeCodeBatch, as symbolizeInlinedCode would.
+  std::vector<DIInliningInfo>
+  symbolizeInlinedCodeBatch(ArrayRef<ModuleAddress> Addresses,
+                            function_ref<void(Error)> HandleLoadError,
+                            StringRef DWPName = "");
+
+  /// Release the loaded modules and the cached results.
   void flush();
 
   static std::string
@@ -75,6 +105,25 @@ private:
   // corresponding debug info. These objects can be the same.
   using ObjectPair = std::pair<ObjectFile *, ObjectFile *>;
 
+  /// Code symbolization results for one module, by the offset they were
+  /// requested for. Profilers ask for the same hot addresses over and over.
+  struct CachedResults {
+    DenseMap<uint64_t, DILineInfo> Code;
+    DenseMap<uint64_t, DIInliningInfo> InlinedCode;
+  };
+
+  DILineInfo resolveCode(const SymbolizableModule &Info,
+                         uint64_t ModuleOffset) const;
+  DIInliningInfo resolveInlinedCode(const SymbolizableModule &Info,
+                                    uint64_t ModuleOffset) const;
+
+  template <typename ResultT, typename ResolveFn>
+  std::vector<ResultT>
+  symbolizeBatch(ArrayRef<ModuleAddress> Addresses,
+                 function_ref<void(Error)> HandleLoadError, StringRef DWPName,
+                 DenseMap<uint64_t, ResultT> CachedResults::*Cache,
+                 ResolveFn Resolve);
+
   /// Returns a SymbolizableModule or an error if loading debug info failed.
   /// Only one attempt is made to load a module, and errors during loading are
   /// only reported once. Subsequent calls to get module info for a module that
@@ -101,6 +150,9 @@ private:
 
   std::map<std::string, std::unique_ptr<SymbolizableModule>> Modules;
 
+  /// Filled in only if Opts.CacheResults is set.
+  std::map<std::string, CachedResults> ResultsForModule;
+
   /// Contains cached results of getOrCreateObjectPair().
   std::map<std::pair<std::string, std::string>, ObjectPair>
       ObjectPairForPathArch;
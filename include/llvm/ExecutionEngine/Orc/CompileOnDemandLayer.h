@@ -83,6 +83,16 @@ public:
   /// symbol in them is requested.
   static Optional<GlobalValueSet> compileWholeModule(GlobalValueSet Requested);
 
+  /// Speculation function. Given a partition that is about to be compiled,
+  /// returns the functions likely to be called soon after it, which are then
+  /// compiled ahead of their first call.
+  using SpeculateFunction =
+      std::function<GlobalValueSet(const GlobalValueSet &Partition)>;
+
+  /// Off-the-shelf speculation which returns the functions that the partition
+  /// calls directly.
+  static GlobalValueSet speculateDirectCallees(const GlobalValueSet &Partition);
+
   /// Construct a CompileOnDemandLayer.
   CompileOnDemandLayer(ExecutionSession &ES, IRLayer &BaseLayer,
                         LazyCallThroughManager &LCTMgr,
@@ -91,10 +101,22 @@ public:
   /// Sets the partition function.
   void setPartitionFunction(PartitionFunction Partition);
 
+  /// Sets the speculation function. Speculated functions are dispatched like
+  /// any other materialization, so they are only compiled in the background
+  /// if the ExecutionSession has materialization threads. Functions compiled
+  /// speculatively do not speculate further themselves.
+  void setSpeculateFunction(SpeculateFunction Speculate);
+
   /// Emits the given module. This should not be called by clients: it will be
   /// called by the JIT when a definition added via the add method is requested.
   void emit(MaterializationResponsibility R, ThreadSafeModule TSM) override;
 
+  /// Point the stub for the callable Name at NewAddr, e.g. to swap in a
+  /// recompiled body. ImplD is the JITDylib this layer emitted Name's body to.
+  /// Stubs that have not been built yet, because Name has not been looked up
+  /// yet, are left alone.
+  Error redirect(JITDylib &ImplD, StringRef Name, JITTargetAddress NewAddr);
+
 private:
   struct PerDylibResources {
   public:
@@ -120,6 +142,12 @@ private:
   void emitPartition(MaterializationResponsibility R, ThreadSafeModule TSM,
                      IRMaterializationUnit::SymbolNameToDefinitionMap Defs);
 
+  SymbolNameSet getSpeculativeSymbols(const MaterializationResponsibility &R,
+                                      const Module &M,
+                                      const GlobalValueSet &Partition);
+
+  void speculate(JITDylib &ImplD, SymbolNameSet Names);
+
   mutable std::mutex CODLayerMutex;
 
   IRLayer &BaseLayer;
@@ -127,6 +155,8 @@ private:
   IndirectStubsManagerBuilder BuildIndirectStubsManager;
   PerDylibResourcesMap DylibResources;
   PartitionFunction Partition = compileRequested;
+  SpeculateFunction Speculate;
+  SymbolNameSet Speculated;
   SymbolLinkagePromoter PromoteSymbols;
 };
 
@@ -25,6 +25,9 @@
 #define DEBUG_TYPE "orc"
 
 namespace llvm {
+
+class ThreadPool;
+
 namespace orc {
 
 // Forward declare some classes.
@@ -710,6 +713,9 @@ public:
   /// SymbolStringPools may be shared between ExecutionSessions.
   ExecutionSession(std::shared_ptr<SymbolStringPool> SSP = nullptr);
 
+  /// Waits for any materialization threads to finish their work.
+  ~ExecutionSession();
+
   /// Add a symbol name to the SymbolStringPool and return a pointer to it.
   SymbolStringPtr intern(StringRef SymName) { return SSP->intern(SymName); }
 
@@ -759,6 +765,19 @@ public:
     return *this;
   }
 
+  /// Materialize units on a pool of NumThreads threads owned by this session,
+  /// rather than on the thread that triggered them, so that independent units
+  /// are compiled in parallel. Replaces the materialization dispatch function.
+  /// Without LLVM_ENABLE_THREADS units are still materialized on the current
+  /// thread.
+  ExecutionSession &setNumMaterializationThreads(unsigned NumThreads);
+
+  /// Block until every unit dispatched to the materialization threads so far,
+  /// and every unit those dispatch in turn, has been materialized. Clients
+  /// should call this before destroying the layers those units refer to. Must
+  /// not be called from a materialization thread.
+  void waitForMaterializationThreads();
+
   void legacyFailQuery(AsynchronousSymbolQuery &Q, Error Err);
 
   using LegacyAsyncLookupFunction = std::function<SymbolNameSet(
@@ -868,6 +887,8 @@ private:
   mutable std::recursive_mutex OutstandingMUsMutex;
   std::vector<std::pair<JITDylib *, std::unique_ptr<MaterializationUnit>>>
       OutstandingMUs;
+
+  std::unique_ptr<ThreadPool> MaterializationThreads;
 };
 
 template <typename Func>
@@ -22,7 +22,8 @@
 #include "llvm/ExecutionEngine/Orc/ObjectTransformLayer.h"
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
-#include "llvm/Support/ThreadPool.h"
+#include "llvm/ExecutionEngine/Orc/TierUpLayer.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
 
 namespace llvm {
 namespace orc {
@@ -105,6 +106,15 @@ public:
   /// Returns a reference to the ObjLinkingLayer
   RTDyldObjectLinkingLayer &getObjLinkingLayer() { return ObjLinkingLayer; }
 
+  /// Returns a reference to the mapper that JIT'd code and data are
+  /// allocated from. Its memory is not recycled before the LLJIT instance is
+  /// destroyed, see PooledMemoryMapper.
+  PooledMemoryMapper &getMemoryMapper() { return MemMapper; }
+
+  /// Set an ObjectCache (e.g. a PersistentObjectCache) to query before
+  /// compiling each module. Must be called before any module is added.
+  void setObjectCache(ObjectCache *ObjCache) { this->ObjCache = ObjCache; }
+
 protected:
 
   /// Create an LLJIT instance with a single compile thread.
@@ -125,8 +135,10 @@ protected:
   JITDylib &Main;
 
   DataLayout DL;
-  std::unique_ptr<ThreadPool> CompileThreads;
 
+  ObjectCache *ObjCache = nullptr;
+
+  PooledMemoryMapper MemMapper;
   RTDyldObjectLinkingLayer ObjLinkingLayer;
   IRCompileLayer CompileLayer;
 
@@ -145,6 +157,9 @@ public:
   Create(JITTargetMachineBuilder JTMB, DataLayout DL,
          JITTargetAddress ErrorAddr, unsigned NumCompileThreads = 0);
 
+  /// Waits for all compile threads to complete.
+  ~LLLazyJIT();
+
   /// Set an IR transform (e.g. pass manager pipeline) to run on each function
   /// when it is compiled.
   void setLazyCompileTransform(IRTransformLayer::TransformFunction Transform) {
@@ -157,6 +172,27 @@ public:
     CODLayer.setPartitionFunction(std::move(Partition));
   }
 
+  /// Sets the speculation function. Multi-threaded instances compile the
+  /// direct callees of each function on the compile threads by default; pass
+  /// an empty function to turn this off.
+  void
+  setSpeculateFunction(CompileOnDemandLayer::SpeculateFunction Speculate) {
+    CODLayer.setSpeculateFunction(std::move(Speculate));
+  }
+
+  /// Enable tiered compilation, which requires a multi-threaded instance.
+  /// Functions are first compiled with the lazy compile transform, at the
+  /// CodeGenOpt level of the JITTargetMachineBuilder the instance was created
+  /// with; both should be cheap. The threshold applies per module, not per
+  /// function: each module that the CompileOnDemandLayer emits shares one
+  /// counter among its functions, and once they have been entered Threshold
+  /// times in total the whole module is recompiled in the background with
+  /// Transform at OptLevel. Later calls through the stubs of its functions run
+  /// the new code. Must be called before any module is added.
+  Error enableTieredCompilation(
+      unsigned Threshold, IRTransformLayer::TransformFunction Transform,
+      CodeGenOpt::Level OptLevel = CodeGenOpt::Aggressive);
+
   /// Add a module to be lazily compiled to JITDylib JD.
   Error addLazyIRModule(JITDylib &JD, ThreadSafeModule M);
 
@@ -183,7 +219,13 @@ private:
   std::function<std::unique_ptr<IndirectStubsManager>()> ISMBuilder;
 
   IRTransformLayer TransformLayer;
+  TierUpLayer TierUp;
   CompileOnDemandLayer CODLayer;
+
+  // Only set for multi-threaded instances.
+  Optional<JITTargetMachineBuilder> TierUpJTMB;
+  std::unique_ptr<IRCompileLayer> TierUpCompileLayer;
+  std::unique_ptr<IRTransformLayer> TierUpTransformLayer;
 };
 
 } // End namespace orc
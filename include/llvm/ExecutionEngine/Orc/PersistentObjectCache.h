@@ -0,0 +1,77 @@
+//===- PersistentObjectCache.h - On-disk cache of JIT'd objects -*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// An ObjectCache that keeps compiled objects in a directory, so that they
+// survive across runs of a JIT.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_ORC_PERSISTENTOBJECTCACHE_H
+#define LLVM_EXECUTIONENGINE_ORC_PERSISTENTOBJECTCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Error.h"
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace llvm {
+namespace orc {
+
+class JITTargetMachineBuilder;
+
+/// Content-addressed on-disk object cache.
+///
+///   Objects are keyed by a hash of the module's bitcode, the LLVM version and
+/// the code generation settings of the JITTargetMachineBuilder the cache was
+/// created for, so the cache directory can be shared by JITs with different
+/// settings and across LLVM upgrades. Entries are stored under the names
+/// pruneCache expects, written atomically, and memory-mapped when loaded.
+///
+///   Give the cache to the compile function (SimpleCompiler or
+/// ConcurrentIRCompiler) of an IRCompileLayer, or to LLJIT::setObjectCache.
+class PersistentObjectCache : public ObjectCache {
+public:
+  /// Create a cache in CacheDir, creating the directory if needed, and prune
+  /// it according to Policy.
+  static Expected<std::unique_ptr<PersistentObjectCache>>
+  Create(StringRef CacheDir, const JITTargetMachineBuilder &JTMB,
+         CachePruningPolicy Policy = CachePruningPolicy());
+
+  std::unique_ptr<MemoryBuffer> getObject(const Module *M) override;
+
+  void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj) override;
+
+  /// Prune the cache directory according to the policy given at creation.
+  /// Returns true if pruning was due.
+  bool prune();
+
+private:
+  PersistentObjectCache(std::string CacheDir, std::string TargetKey,
+                        CachePruningPolicy Policy)
+      : CacheDir(std::move(CacheDir)), TargetKey(std::move(TargetKey)),
+        Policy(std::move(Policy)) {}
+
+  std::string getEntryPath(const Module &M);
+
+  std::string CacheDir;
+  std::string TargetKey;
+  CachePruningPolicy Policy;
+
+  /// Entry paths of modules looked up but not compiled yet. Code generation
+  /// changes the module, so its key has to be computed before.
+  std::mutex PendingMutex;
+  DenseMap<const Module *, std::string> Pending;
+};
+
+} // end namespace orc
+} // end namespace llvm
+
+#endif // LLVM_EXECUTIONENGINE_ORC_PERSISTENTOBJECTCACHE_H
@@ -0,0 +1,102 @@
+//===- TierUpLayer.h - Recompile hot code in the background -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// An IR layer that instruments each module passed through it to count calls
+// to its functions, and recompiles the module through a second layer once
+// those functions turn out to be hot.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_ORC_TIERUPLAYER_H
+#define LLVM_EXECUTIONENGINE_ORC_TIERUPLAYER_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/Orc/Layer.h"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+namespace orc {
+
+/// Tiered compilation layer.
+///
+///   Modules are emitted to the base layer, which should compile them quickly
+/// (e.g. at CodeGenOpt::None), with a counter added to the entry of each of
+/// their functions. Once the functions of a module have been entered Threshold
+/// times in total, a copy of the original module is emitted to the tier-up
+/// layer, which should optimize it, on the ExecutionSession's materialization
+/// threads. The copy's functions are renamed, its variables refer to those of
+/// the first copy, and each function's stub is then redirected to its new
+/// body.
+///
+///   Until then only the original module's bitcode is kept; the copy is
+/// parsed from it when it is materialized.
+///
+///   This only pays off for functions called through stubs, as they are in a
+/// CompileOnDemandLayer's output. Modules with local symbols, aliases or ifuncs
+/// are never recompiled.
+class TierUpLayer : public IRLayer {
+public:
+  /// Point the stub for the function Name at NewAddr. JD is the JITDylib the
+  /// function's first-tier body was emitted to.
+  using RedirectFunction = std::function<Error(
+      JITDylib &JD, StringRef Name, JITTargetAddress NewAddr)>;
+
+  TierUpLayer(ExecutionSession &ES, IRLayer &BaseLayer);
+
+  /// Enable recompilation through TierUpBaseLayer for modules emitted from
+  /// here on. Must be called before any module is emitted.
+  void enable(unsigned Threshold, IRLayer &TierUpBaseLayer,
+              RedirectFunction Redirect);
+
+  void emit(MaterializationResponsibility R, ThreadSafeModule TSM) override;
+
+private:
+  /// A module waiting to get hot. Its bitcode and symbols are moved out when
+  /// it does; the rest lives as long as the layer, since the first tier's
+  /// code keeps a pointer to it.
+  struct Candidate {
+    TierUpLayer *Layer;
+    JITDylib *JD;
+    /// The original module, to make the copy from.
+    std::string ModuleName;
+    SmallVector<char, 0> Bitcode;
+    /// The original name of each function, and its name in the copy.
+    std::vector<std::pair<SymbolStringPtr, SymbolStringPtr>> Functions;
+    /// The symbols the copy defines.
+    SymbolFlagsMap CopySymbols;
+    std::atomic<bool> Started{false};
+  };
+
+  /// Called from JIT'd code when a candidate gets hot.
+  static void tierUp(void *Ctx);
+
+  void emitTierUp(Candidate &C);
+
+  JITDylib &getTierUpDylib(JITDylib &JD);
+
+  std::mutex LayerMutex;
+  IRLayer &BaseLayer;
+  IRLayer *TierUpBaseLayer = nullptr;
+  RedirectFunction Redirect;
+  unsigned Threshold = 0;
+  std::map<JITDylib *, JITDylib *> TierUpDylibs;
+  std::vector<std::unique_ptr<Candidate>> Candidates;
+};
+
+} // End namespace orc
+} // End namespace llvm
+
+#endif // LLVM_EXECUTIONENGINE_ORC_TIERUPLAYER_H
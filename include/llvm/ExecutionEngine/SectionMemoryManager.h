@@ -19,6 +19,8 @@
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
 #include "llvm/Support/Memory.h"
 #include <cstdint>
+#include <map>
+#include <mutex>
 #include <string>
 #include <system_error>
 
@@ -189,6 +191,82 @@ private:
   MemoryMapper &MMapper;
 };
 
+/// A MemoryMapper that carves the blocks it hands out from large slabs of
+/// memory reserved from the operating system, and keeps released blocks for
+/// reuse rather than unmapping them.
+///
+/// One PooledMemoryMapper is meant to be shared by all the
+/// SectionMemoryManagers of a JIT. Memory released when a memory manager is
+/// destroyed is then recycled for later objects, and consecutive objects end
+/// up next to each other instead of scattered over the address space.
+///
+/// Memory is only recycled once its memory manager is destroyed. The legacy
+/// object layers destroy it when the object is removed, but
+/// orc::RTDyldObjectLinkingLayer keeps every memory manager until the layer
+/// itself is destroyed, so with it (and thus with LLJIT) removing a module or
+/// a JITDylib does not give its memory back to the pool. Code and data are carved from separate
+/// slabs, so that changing the permissions of one never splits the pages of
+/// the other.
+///
+/// Code slabs may be backed by huge pages to reduce iTLB misses (see
+/// sys::Memory::MF_HUGE_PAGE). The pages of a slab are split while its code
+/// is being written, and may be merged again by the kernel once all of it
+/// has been made executable.
+///
+/// Slabs are only unmapped when the mapper is destroyed, which must happen
+/// after all the memory managers using it have been destroyed. The mapper may
+/// be used by several threads at once.
+class PooledMemoryMapper final : public SectionMemoryManager::MemoryMapper {
+public:
+  /// Create a mapper reserving slabs of at least \p SlabSize bytes.
+  PooledMemoryMapper(size_t SlabSize = 16 * 1024 * 1024,
+                     bool HugePagesForCode = false);
+  PooledMemoryMapper(const PooledMemoryMapper &) = delete;
+  void operator=(const PooledMemoryMapper &) = delete;
+  ~PooledMemoryMapper() override;
+
+  /// Back code slabs reserved from here on with huge pages.
+  void setHugePagesForCode(bool HugePagesForCode);
+
+  /// Hand out at least \p NumBytes bytes, rounded up to a whole number of
+  /// pages. If the pages following \p NearBlock are free they are used, so
+  /// that one memory manager's blocks stay contiguous.
+  sys::MemoryBlock
+  allocateMappedMemory(SectionMemoryManager::AllocationPurpose Purpose,
+                       size_t NumBytes, const sys::MemoryBlock *const NearBlock,
+                       unsigned Flags, std::error_code &EC) override;
+
+  std::error_code protectMappedMemory(const sys::MemoryBlock &Block,
+                                      unsigned Flags) override;
+
+  /// Make \p M writable again and keep it for reuse.
+  std::error_code releaseMappedMemory(sys::MemoryBlock &M) override;
+
+  /// The number of bytes reserved from the operating system.
+  size_t getReservedSize() const;
+
+  /// The number of reserved bytes not currently handed out.
+  size_t getFreeSize() const;
+
+private:
+  struct Pool {
+    SmallVector<sys::MemoryBlock, 4> Slabs;
+    /// Free ranges, keyed by start address, with adjacent ranges merged.
+    std::map<uintptr_t, size_t> Free;
+  };
+
+  Pool &getPool(SectionMemoryManager::AllocationPurpose Purpose) {
+    return Purpose == SectionMemoryManager::AllocationPurpose::Code ? CodePool
+                                                                    : DataPool;
+  }
+
+  mutable std::mutex PoolMutex;
+  size_t SlabSize;
+  bool HugePagesForCode;
+  Pool CodePool;
+  Pool DataPool;
+};
+
 } // end namespace llvm
 
 #endif // LLVM_EXECUTION_ENGINE_SECTION_MEMORY_MANAGER_H
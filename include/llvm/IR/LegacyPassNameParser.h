@@ -65,17 +65,23 @@ public:
 
   // Implement the PassRegistrationListener callbacks used to populate our map
   //
+  // Pass names are unique; the PassRegistry diagnoses duplicates.
   void passRegistered(const PassInfo *P) override {
     if (ignorablePass(P)) return;
-    if (findOption(P->getPassArgument().data()) != getNumOptions()) {
-      errs() << "Two passes with the same argument (-"
-           << P->getPassArgument() << ") attempted to be registered!\n";
-      llvm_unreachable(nullptr);
-    }
     addLiteralOption(P->getPassArgument().data(), P, P->getPassName().data());
   }
   void passEnumerate(const PassInfo *P) override { passRegistered(P); }
 
+  // parse - The passes of lazily initialized libraries are only registered,
+  // and so only added to our map, once one of them is looked up by name.
+  bool parse(cl::Option &O, StringRef ArgName, StringRef Arg,
+             const PassInfo *&V) {
+    StringRef Name = O.hasArgStr() ? Arg : ArgName;
+    if (findOption(Name) == getNumOptions())
+      PassRegistry::getPassRegistry()->getPassInfo(Name);
+    return cl::parser<const PassInfo *>::parse(O, ArgName, Arg, V);
+  }
+
   // printOptionInfo - Print out information about this option.  Override the
   // default implementation to sort the table before we print...
   void printOptionInfo(const cl::Option &O, size_t GlobalWidth) const override {
@@ -55,6 +55,22 @@ struct Config {
   /// Disable entirely the optimizer, including importing for ThinLTO
   bool CodeGenOnly = false;
 
+  /// When code generating the regular LTO module in parallel, split it at
+  /// function granularity into partitions of roughly equal instruction count
+  /// instead of distributing functions by a hash of their name.
+  bool BalanceCodeGenPartitions = false;
+
+  /// When code generating the regular LTO module in parallel and a cache is
+  /// passed to LTO::run, cache the object file of each partition, keyed on
+  /// the partition's bitcode and the code generation options. Partitions
+  /// whose functions did not change are then not code generated again.
+  bool CacheCodeGenPartitions = false;
+
+  /// If this field is set, the ThinLTO import lists are stored in this file
+  /// and reused by the next link for modules whose imports cannot have
+  /// changed. See ComputeCrossModuleImport.
+  std::string ThinLTOImportCachePath;
+
   /// If this field is set, the set of passes run in the middle-end optimizer
   /// will be the one specified by the string. Only works with the new pass
   /// manager as the old one doesn't have this ability.
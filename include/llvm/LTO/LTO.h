@@ -72,6 +72,12 @@ void computeLTOCacheKey(
     const std::set<GlobalValue::GUID> &CfiFunctionDefs = {},
     const std::set<GlobalValue::GUID> &CfiFunctionDecls = {});
 
+/// Computes a unique hash for a regular LTO codegen partition from its
+/// \p Bitcode and the code generation options in \p Conf.
+/// The hash is produced in \p Key.
+void computeLTOCodeGenCacheKey(SmallString<40> &Key, const lto::Config &Conf,
+                               StringRef Bitcode);
+
 namespace lto {
 
 /// Given the original \p Path to an output file, replace any path
@@ -178,6 +184,12 @@ public:
   virtual ~NativeObjectStream() = default;
 };
 
+/// Create a stream that writes a native object straight into a mapping of the
+/// file at \p Path, rather than through a file descriptor. The file is written
+/// out when the stream is destroyed; failing to do so is a fatal error.
+Expected<std::unique_ptr<NativeObjectStream>>
+createNativeObjectFileStream(StringRef Path);
+
 /// This type defines the callback to add a native object that is generated on
 /// the fly.
 ///
@@ -395,7 +407,7 @@ private:
   Error addThinLTO(BitcodeModule BM, ArrayRef<InputFile::Symbol> Syms,
                    const SymbolResolution *&ResI, const SymbolResolution *ResE);
 
-  Error runRegularLTO(AddStreamFn AddStream);
+  Error runRegularLTO(AddStreamFn AddStream, NativeObjectCache Cache);
   Error runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache);
 
   mutable bool CalledGetMaxTasks = false;
@@ -35,9 +35,12 @@ namespace lto {
 
 /// Runs a regular LTO backend. The regular LTO backend can also act as the
 /// regular LTO phase of ThinLTO, which may need to access the combined index.
+/// If \p Cache is set and the module is split for parallel code generation,
+/// the object file of each partition is looked up in and added to the cache.
 Error backend(Config &C, AddStreamFn AddStream,
               unsigned ParallelCodeGenParallelismLevel,
-              std::unique_ptr<Module> M, ModuleSummaryIndex &CombinedIndex);
+              std::unique_ptr<Module> M, ModuleSummaryIndex &CombinedIndex,
+              NativeObjectCache Cache = nullptr);
 
 /// Runs a ThinLTO backend.
 Error thinBackend(Config &C, unsigned Task, AddStreamFn AddStream, Module &M,
@@ -263,6 +263,10 @@ namespace llvm {
                                bool CanBeUnnamed);
     MCSymbol *createSymbol(StringRef Name, bool AlwaysAddSuffix,
                            bool IsTemporary);
+    /// Create a named symbol; \p NameHash is StringMapImpl::hash(Name), which
+    /// the symbol tables share.
+    MCSymbol *createNamedSymbol(StringRef Name, unsigned NameHash,
+                                bool AlwaysAddSuffix, bool IsTemporary);
 
     MCSymbol *getOrCreateDirectionalLocalSymbol(unsigned LocalLabelVal,
                                                 unsigned Instance);
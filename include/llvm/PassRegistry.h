@@ -20,7 +20,9 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CBindingWrapping.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/RWMutex.h"
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -48,6 +50,21 @@ class PassRegistry {
   std::vector<std::unique_ptr<const PassInfo>> ToFree;
   std::vector<PassRegistrationListener *> Listeners;
 
+  /// Library initializers whose passes have not been registered yet. They run
+  /// the first time a lookup misses, or when the passes are enumerated.
+  using InitializerFn = void (*)(PassRegistry &);
+  mutable std::vector<InitializerFn> LazyInitializers;
+  mutable sys::SmartMutex<true> LazyInitializersLock;
+  /// Set while initializers are queued or running, so that lookups that miss
+  /// otherwise need not take either lock.
+  mutable std::atomic<bool> HasLazyInitializers{false};
+
+  /// runLazyInitializers - Register the passes of all the pending library
+  /// initializers, or wait for another thread that is registering them.
+  /// Returns false if there was nothing to do, in which case a lookup that
+  /// missed need not be retried.
+  bool runLazyInitializers() const;
+
 public:
   PassRegistry() = default;
   ~PassRegistry();
@@ -69,6 +86,13 @@ public:
   /// registry.  Required in order to use the pass with a PassManager.
   void registerPass(const PassInfo &PI, bool ShouldFree = false);
 
+  /// registerLazyInitializer - Defer a library initializer such as
+  /// initializeScalarOpts until one of its passes is needed. Tools that link
+  /// many passes but use few of them save registering the rest at startup.
+  /// The initializer runs the first time a pass is looked up that has not been
+  /// registered yet, or when the registered passes are enumerated.
+  void registerLazyInitializer(void (*Initializer)(PassRegistry &));
+
   /// registerAnalysisGroup - Register an analysis group (or a pass implementing
   // an analysis group) with the registry.  Like registerPass, this is required
   // in order for a PassManager to be able to use this group/pass.
@@ -53,11 +53,27 @@ private:
   bool StoreModuleDesc = false;
 };
 
+/// Instrumentation that records every pass and analysis run as a section of
+/// the time-trace profile (see llvm/Support/TimeProfiler.h).
+///
+/// Callbacks are registered only if the profiler has been initialized.
+class TimeProfilingPassesHandler {
+public:
+  TimeProfilingPassesHandler() = default;
+
+  void registerCallbacks(PassInstrumentationCallbacks &PIC);
+
+private:
+  bool runBeforePass(StringRef PassID, Any IR);
+  void runAfterPass();
+};
+
 /// This class provides an interface to register all the standard pass
 /// instrumentations and manages their state (if any).
 class StandardInstrumentations {
   PrintIRInstrumentation PrintIR;
   TimePassesHandler TimePasses;
+  TimeProfilingPassesHandler TimeProfilingPasses;
 
 public:
   StandardInstrumentations() = default;
@@ -26,6 +26,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemAlloc.h"
+#include "llvm/Support/MemoryAccounting.h"
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
@@ -119,8 +120,68 @@ namespace detail {
 void printBumpPtrAllocatorStats(unsigned NumSlabs, size_t BytesAllocated,
                                 size_t TotalMemory);
 
+/// Check if slabs of \p Size bytes are kept in the process-wide slab pool.
+inline bool isPooledSlabSize(size_t Size) {
+#if LLVM_ADDRESS_SANITIZER_BUILD || LLVM_MEMORY_SANITIZER_BUILD
+  // Leave the slabs to malloc, which the sanitizers track.
+  return false;
+#else
+  return Size >= 4096 && Size <= 65536 && isPowerOf2_64(Size);
+#endif
+}
+
+void *allocatePooledSlab(size_t Size);
+void deallocatePooledSlab(void *Slab, size_t Size);
+size_t releasePooledSlabs();
+
 } // end namespace detail
 
+/// The allocator of the slabs of BumpPtrAllocators.
+///
+/// Allocators that are created and destroyed for every function, like those
+/// of MachineFunction and SelectionDAG, would otherwise malloc and free the
+/// same few slabs over and over. Slabs of the common sizes are instead kept in
+/// a process-wide pool when deallocated, split in a few shards that threads
+/// pick from so that they rarely contend, and reused by the next allocator.
+/// The pool takes its memory from the system in huge-page backed chunks,
+/// which keeps long-lived slabs from fragmenting the malloc heap. Other sizes
+/// go to malloc.
+///
+/// Once the free slabs add up to a lot more than after the last release,
+/// chunks in which no slab is in use are given back to the system; a process
+/// can also do so itself with releaseFreeMemory().
+class SlabAllocator : public AllocatorBase<SlabAllocator> {
+public:
+  void Reset() {}
+
+  /// Return the chunks of the pool in which no slab is in use to the system,
+  /// e.g. when a long-running process is done with a large compilation. Free
+  /// slabs in other chunks stay pooled. Returns the number of bytes released.
+  static size_t releaseFreeMemory() { return detail::releasePooledSlabs(); }
+
+  LLVM_ATTRIBUTE_RETURNS_NONNULL void *Allocate(size_t Size,
+                                                size_t /*Alignment*/) {
+    if (detail::isPooledSlabSize(Size))
+      return detail::allocatePooledSlab(Size);
+    return safe_malloc(Size);
+  }
+
+  // Pull in base class overloads.
+  using AllocatorBase<SlabAllocator>::Allocate;
+
+  void Deallocate(const void *Ptr, size_t Size) {
+    if (detail::isPooledSlabSize(Size))
+      detail::deallocatePooledSlab(const_cast<void *>(Ptr), Size);
+    else
+      free(const_cast<void *>(Ptr));
+  }
+
+  // Pull in base class overloads.
+  using AllocatorBase<SlabAllocator>::Deallocate;
+
+  void PrintStats() const {}
+};
+
 /// Allocate memory in an ever growing pool, as if by bump-pointer.
 ///
 /// This isn't strictly a bump-pointer allocator as it uses backing slabs of
@@ -132,10 +193,10 @@ void printBumpPtrAllocatorStats(unsigned NumSlabs, size_t BytesAllocated,
 /// Note that this also has a threshold for forcing allocations above a certain
 /// size into their own slab.
 ///
-/// The BumpPtrAllocatorImpl template defaults to using a MallocAllocator
-/// object, which wraps malloc, to allocate memory, but it can be changed to
-/// use a custom allocator.
-template <typename AllocatorT = MallocAllocator, size_t SlabSize = 4096,
+/// The BumpPtrAllocatorImpl template defaults to using a SlabAllocator object,
+/// which recycles slabs through a process-wide pool, to allocate memory, but
+/// it can be changed to use a custom allocator.
+template <typename AllocatorT = SlabAllocator, size_t SlabSize = 4096,
           size_t SizeThreshold = SlabSize>
 class BumpPtrAllocatorImpl
     : public AllocatorBase<
@@ -158,9 +219,11 @@ public:
       : CurPtr(Old.CurPtr), End(Old.End), Slabs(std::move(Old.Slabs)),
         CustomSizedSlabs(std::move(Old.CustomSizedSlabs)),
         BytesAllocated(Old.BytesAllocated), RedZoneSize(Old.RedZoneSize),
+        AccountedMemory(Old.AccountedMemory), Category(Old.Category),
         Allocator(std::move(Old.Allocator)) {
     Old.CurPtr = Old.End = nullptr;
     Old.BytesAllocated = 0;
+    Old.AccountedMemory = 0;
     Old.Slabs.clear();
     Old.CustomSizedSlabs.clear();
   }
@@ -178,12 +241,15 @@ public:
     End = RHS.End;
     BytesAllocated = RHS.BytesAllocated;
     RedZoneSize = RHS.RedZoneSize;
+    AccountedMemory = RHS.AccountedMemory;
+    Category = RHS.Category;
     Slabs = std::move(RHS.Slabs);
     CustomSizedSlabs = std::move(RHS.CustomSizedSlabs);
     Allocator = std::move(RHS.Allocator);
 
     RHS.CurPtr = RHS.End = nullptr;
     RHS.BytesAllocated = 0;
+    RHS.AccountedMemory = 0;
     RHS.Slabs.clear();
     RHS.CustomSizedSlabs.clear();
     return *this;
@@ -247,6 +313,7 @@ public:
       // pieces returned from this method.  So poison the whole slab.
       __asan_poison_memory_region(NewSlab, PaddedSize);
       CustomSizedSlabs.push_back(std::make_pair(NewSlab, PaddedSize));
+      accountSlab(PaddedSize);
 
       uintptr_t AlignedAddr = alignAddr(NewSlab, Alignment);
       assert(AlignedAddr + Size <= (uintptr_t)NewSlab + PaddedSize);
@@ -352,6 +419,20 @@ public:
     RedZoneSize = NewSize;
   }
 
+  /// Set the category the slabs of this allocator are accounted for when
+  /// memory accounting is enabled. The memory allocated so far is moved over
+  /// to the new category.
+  void setMemoryCategory(MemoryCategory NewCategory) {
+    if (AccountedMemory) {
+      detail::recordMemoryUse(Category, -static_cast<int64_t>(AccountedMemory));
+      detail::recordMemoryUse(NewCategory,
+                              static_cast<int64_t>(AccountedMemory));
+    }
+    Category = NewCategory;
+  }
+
+  MemoryCategory getMemoryCategory() const { return Category; }
+
   void PrintStats() const {
     detail::printBumpPtrAllocatorStats(Slabs.size(), BytesAllocated,
                                        getTotalMemory());
@@ -381,6 +462,13 @@ private:
   /// a sanitizer.
   size_t RedZoneSize = 1;
 
+  /// The bytes of slabs reported to the memory accounting and not released
+  /// yet. Accounting may have been enabled after some slabs were allocated.
+  size_t AccountedMemory = 0;
+
+  /// The subsystem the slabs are accounted for.
+  MemoryCategory Category = MemoryCategory::Other;
+
   /// The allocator instance we use to get slabs of memory.
   AllocatorT Allocator;
 
@@ -405,6 +493,22 @@ private:
     Slabs.push_back(NewSlab);
     CurPtr = (char *)(NewSlab);
     End = ((char *)NewSlab) + AllocatedSlabSize;
+    accountSlab(AllocatedSlabSize);
+  }
+
+  void accountSlab(size_t Size) {
+    if (LLVM_UNLIKELY(isMemoryAccountingEnabled())) {
+      AccountedMemory += Size;
+      detail::recordMemoryUse(Category, static_cast<int64_t>(Size));
+    }
+  }
+
+  void unaccountSlab(size_t Size) {
+    if (LLVM_UNLIKELY(AccountedMemory)) {
+      Size = std::min(Size, AccountedMemory);
+      AccountedMemory -= Size;
+      detail::recordMemoryUse(Category, -static_cast<int64_t>(Size));
+    }
   }
 
   /// Deallocate a sequence of slabs.
@@ -414,6 +518,7 @@ private:
       size_t AllocatedSlabSize =
           computeSlabSize(std::distance(Slabs.begin(), I));
       Allocator.Deallocate(*I, AllocatedSlabSize);
+      unaccountSlab(AllocatedSlabSize);
     }
   }
 
@@ -423,6 +528,7 @@ private:
       void *Ptr = PtrAndSize.first;
       size_t Size = PtrAndSize.second;
       Allocator.Deallocate(Ptr, Size);
+      unaccountSlab(Size);
     }
   }
 
@@ -456,6 +562,11 @@ public:
     return *this;
   }
 
+  /// Set the category the memory of this allocator is accounted for.
+  void setMemoryCategory(MemoryCategory Category) {
+    Allocator.setMemoryCategory(Category);
+  }
+
   /// Call the destructor of each allocated object and deallocate all but the
   /// current slab and reset the current pointer to the beginning of it, freeing
   /// all memory allocated so far.
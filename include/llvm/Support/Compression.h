@@ -13,12 +13,14 @@
 #ifndef LLVM_SUPPORT_COMPRESSION_H
 #define LLVM_SUPPORT_COMPRESSION_H
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Error.h"
+#include <functional>
+#include <string>
 
 namespace llvm {
 template <typename T> class SmallVectorImpl;
-class Error;
-class StringRef;
 
 namespace zlib {
 
@@ -41,6 +43,64 @@ Error uncompress(StringRef InputBuffer,
 
 uint32_t crc32(StringRef Buffer);
 
+/// Compress \p InputBuffer like compress, deflating blocks of it on several
+/// threads. See BlockCompressor.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       int Level = DefaultCompression);
+
+/// BlockCompressor - Compresses data handed to it in pieces into a single
+/// zlib stream, which any zlib can decompress.
+///
+/// The input is cut into fixed-size blocks that are deflated independently,
+/// in parallel, each primed with the last 32 KiB of input before it so that
+/// the ratio stays close to that of one deflate over the whole input. Only a
+/// window of a few blocks per thread is held at any time: compressed blocks
+/// are passed to the sink in order as soon as their window is done, and their
+/// input and output buffers are released. The output depends on the input and
+/// the block size only, not on the number of threads or on how the input was
+/// split into write calls. An input that fits in one block compresses to the
+/// same bytes as compress.
+class BlockCompressor {
+public:
+  using SinkFn = std::function<void(StringRef)>;
+
+  static constexpr size_t DefaultBlockSize = 256 * 1024;
+
+  explicit BlockCompressor(SinkFn Sink, int Level = DefaultCompression,
+                           size_t BlockSize = DefaultBlockSize);
+  BlockCompressor(const BlockCompressor &) = delete;
+  BlockCompressor &operator=(const BlockCompressor &) = delete;
+
+  /// Add \p Data to the input.
+  void write(StringRef Data);
+
+  /// Compress the rest of the input and end the stream. Returns the first
+  /// error zlib reported, if any; the output is unusable in that case.
+  Error finish();
+
+  /// The number of bytes passed to write so far.
+  uint64_t getInputSize() const { return InputSize; }
+
+private:
+  /// Compress \p Data, a whole number of blocks unless \p Final, and pass the
+  /// result to the sink.
+  void compressWindow(StringRef Data, bool Final);
+
+  SinkFn Sink;
+  int Level;
+  size_t BlockSize;
+  size_t WindowSize;
+  /// Input not compressed yet.
+  std::string Pending;
+  /// The input preceding Pending, up to the size of the deflate window.
+  std::string Dictionary;
+  uint64_t InputSize = 0;
+  uint32_t Adler;
+  int Status = 0;
+  bool WroteHeader = false;
+};
+
 }  // End of namespace zlib
 
 } // End of namespace llvm
@@ -18,6 +18,7 @@
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
 
 namespace llvm {
 /// FileOutputBuffer - This interface provides simple way to create an in-memory
@@ -58,6 +59,11 @@ public:
   /// Returns path where file will show up if buffer is committed.
   StringRef getPath() const { return FinalPath; }
 
+  /// Grows or shrinks the buffer to \p NewSize bytes, keeping its content up
+  /// to the smaller of the two sizes. The buffer may move, so pointers into
+  /// it are invalidated.
+  virtual Error resize(size_t NewSize) = 0;
+
   /// Flushes the content of the buffer to its file and deallocates the
   /// buffer.  If commit() is not called before this object's destructor
   /// is called, the file is deleted in the destructor. The optional parameter
@@ -79,6 +85,45 @@ protected:
 
   std::string FinalPath;
 };
+
+/// A raw_pwrite_stream that writes into a FileOutputBuffer, which grows as the
+/// stream does. The unwritten part of the buffer serves as the stream's own
+/// buffer, so that for an on-disk buffer data is formatted straight into the
+/// mapped pages of the output file, without an intermediate copy.
+///
+/// Like a FileOutputBuffer, the file is only written if the stream is
+/// committed; otherwise it is discarded when the stream is destroyed.
+class raw_mapped_file_ostream : public raw_pwrite_stream {
+  std::unique_ptr<FileOutputBuffer> Buffer;
+  /// The bytes written to the buffer, not counting those in the stream's
+  /// buffer.
+  uint64_t Pos = 0;
+  std::error_code EC;
+
+  raw_mapped_file_ostream(std::unique_ptr<FileOutputBuffer> Buffer);
+
+  void write_impl(const char *Ptr, size_t Size) override;
+  void pwrite_impl(const char *Ptr, size_t Size, uint64_t Offset) override;
+  uint64_t current_pos() const override { return Pos; }
+
+  /// Make room for at least \p MinSize bytes and point the stream's buffer
+  /// at the unwritten part of the FileOutputBuffer.
+  void reserve(uint64_t MinSize);
+
+public:
+  /// Create a stream that writes the file at \p FilePath once committed.
+  /// \p SizeHint is the initial size of the buffer; the stream grows it when
+  /// needed. \p Flags are those of FileOutputBuffer::create().
+  static Expected<std::unique_ptr<raw_mapped_file_ostream>>
+  create(StringRef FilePath, size_t SizeHint = 0, unsigned Flags = 0);
+
+  ~raw_mapped_file_ostream() override;
+
+  void reserveExtraSpace(uint64_t ExtraSize) override;
+
+  /// Flush the stream, truncate the file to what was written and commit it.
+  Error commit();
+};
 } // end namespace llvm
 
 #endif
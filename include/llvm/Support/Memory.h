@@ -47,7 +47,12 @@ namespace sys {
     enum ProtectionFlags {
       MF_READ  = 0x1000000,
       MF_WRITE = 0x2000000,
-      MF_EXEC  = 0x4000000
+      MF_EXEC  = 0x4000000,
+      MF_RWE_MASK = 0x7000000,
+      /// Hint that allocateMappedMemory should back the block with huge
+      /// pages. The block is then aligned to, and its size rounded up to, the
+      /// huge page size. Only honored on Linux; ignored elsewhere.
+      MF_HUGE_PAGE = 0x0000001
     };
 
     /// This method allocates a block of memory that is suitable for loading
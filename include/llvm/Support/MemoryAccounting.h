@@ -0,0 +1,112 @@
+//===- MemoryAccounting.h - Memory use by subsystem -------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the accounting of memory by the subsystem it is used for,
+// which -track-memory reports for every timer of -time-passes.
+//
+// Allocators report the memory they get and give back for a category, e.g. a
+// BumpPtrAllocator reports its slabs once it is given a category with
+// setMemoryCategory(). The current and peak use of every category is kept for
+// the whole process, and for regions such as the runs of a pass.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_MEMORYACCOUNTING_H
+#define LLVM_SUPPORT_MEMORYACCOUNTING_H
+
+#include "llvm/Support/Compiler.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace llvm {
+
+enum class MemoryCategory : unsigned char {
+  Other,
+  IR,
+  Metadata,
+  SCEV,
+  SelectionDAG,
+  LiveIntervals,
+  MachineIR,
+  MC
+};
+
+const unsigned NumMemoryCategories = 8;
+
+const char *getMemoryCategoryName(MemoryCategory Category);
+
+namespace detail {
+/// Set by -track-memory.
+extern bool MemoryAccountingEnabled;
+
+void recordMemoryUse(MemoryCategory Category, int64_t Bytes);
+} // end namespace detail
+
+/// Check if memory is being accounted, i.e. if -track-memory was given.
+inline bool isMemoryAccountingEnabled() {
+  return detail::MemoryAccountingEnabled;
+}
+
+/// Like isMemoryAccountingEnabled(), but fixed by the first call. This is for
+/// allocators that lay out their memory differently to account for it, which
+/// must not change while the memory is in use.
+bool isMemoryAccountingEnabledForLayout();
+
+inline void recordMemoryAllocation(MemoryCategory Category, size_t Bytes) {
+  if (LLVM_UNLIKELY(isMemoryAccountingEnabled()))
+    detail::recordMemoryUse(Category, static_cast<int64_t>(Bytes));
+}
+
+inline void recordMemoryDeallocation(MemoryCategory Category, size_t Bytes) {
+  if (LLVM_UNLIKELY(isMemoryAccountingEnabled()))
+    detail::recordMemoryUse(Category, -static_cast<int64_t>(Bytes));
+}
+
+/// Allocate \p Size bytes with ::operator new for an object of \p Category.
+/// Nodes that are allocated one by one, like IR values and metadata, use this
+/// so that they are accounted for. The memory must be released with
+/// deallocateAccounted().
+void *allocateAccounted(size_t Size, MemoryCategory Category);
+
+/// Release memory returned by allocateAccounted().
+void deallocateAccounted(void *Ptr, MemoryCategory Category);
+
+/// The memory use of each category over a part of the compilation.
+struct MemoryUsage {
+  /// The bytes allocated and not deallocated again.
+  int64_t Net[NumMemoryCategories] = {};
+  /// The most bytes in use at any one time, above the use at the start.
+  int64_t Peak[NumMemoryCategories] = {};
+
+  bool empty() const;
+
+  /// Combine the usage of two parts, e.g. two runs of the same pass. The net
+  /// use is added up, the peak is the larger one.
+  MemoryUsage &operator+=(const MemoryUsage &RHS);
+};
+
+/// The state at the start of a region whose memory use is measured.
+struct MemoryRegionStart {
+  int64_t Current[NumMemoryCategories];
+  int64_t OuterPeak[NumMemoryCategories];
+};
+
+/// Start measuring the memory use of a region. Regions must be nested
+/// properly. Memory used by other threads in the meantime is included.
+MemoryRegionStart beginMemoryRegion();
+
+/// Stop measuring the region started by \p Start and return its usage.
+MemoryUsage endMemoryRegion(const MemoryRegionStart &Start);
+
+/// Return the current use and the peak use of each category over the whole
+/// process.
+MemoryUsage getProcessMemoryUsage();
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_MEMORYACCOUNTING_H
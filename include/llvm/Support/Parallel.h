@@ -9,6 +9,7 @@
 #ifndef LLVM_SUPPORT_PARALLEL_H
 #define LLVM_SUPPORT_PARALLEL_H
 
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/MathExtras.h"
@@ -17,6 +18,8 @@
 #include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <numeric>
+#include <vector>
 
 #if defined(_MSC_VER) && LLVM_ENABLE_THREADS
 #pragma warning(push)
@@ -69,15 +72,26 @@ public:
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  bool isDone() const {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
 };
 
 class TaskGroup {
   Latch L;
 
 public:
+  ~TaskGroup();
+
   void spawn(std::function<void()> f);
 
-  void sync() const { L.sync(); }
+  /// Wait for all spawned tasks to finish. When called on a worker thread,
+  /// e.g. from a nested parallel algorithm, the tasks of this group that have
+  /// not started yet are run on this thread in the meantime; other tasks are
+  /// not, so the stack only grows with the nesting of the algorithms.
+  void sync() const;
 };
 
 #if defined(_MSC_VER)
@@ -184,6 +198,109 @@ void parallel_for_each_n(IndexTy Begin, IndexTy End, FuncTy Fn) {
 
 #endif
 
+// The algorithms below split their input into at most MaxChunks chunks of
+// equal size, so that a task is spawned per chunk rather than per element.
+// Chunks hold at least MinChunkSize elements, as spawning a task costs much
+// more than applying a cheap function to one element; inputs smaller than
+// twice that are processed on the calling thread.
+const size_t MaxChunks = 1024;
+const size_t MinChunkSize = 64;
+
+inline size_t getNumChunks(size_t Size) {
+  return std::max<size_t>(1, std::min(MaxChunks, Size / MinChunkSize));
+}
+
+/// Call \p Fn(ChunkIndex, ChunkBegin, ChunkEnd) for \p NumChunks
+/// consecutive chunks of [Begin, End), in parallel. The last chunk is
+/// processed on the calling thread.
+template <class IterTy, class FuncTy>
+void parallel_for_each_chunk(IterTy Begin, IterTy End, size_t NumChunks,
+                             FuncTy Fn) {
+  size_t Size = std::distance(Begin, End);
+  size_t ChunkSize = Size / NumChunks;
+  // The first Size % NumChunks chunks get one element more than the others.
+  size_t NumLarger = Size % NumChunks;
+  TaskGroup TG;
+  for (size_t I = 0; I + 1 < NumChunks; ++I) {
+    IterTy ChunkEnd = std::next(Begin, ChunkSize + (I < NumLarger ? 1 : 0));
+    TG.spawn([=, &Fn] { Fn(I, Begin, ChunkEnd); });
+    Begin = ChunkEnd;
+  }
+  Fn(NumChunks - 1, Begin, End);
+}
+
+template <class IterTy, class ResultTy, class ReduceFuncTy,
+          class TransformFuncTy>
+ResultTy parallel_transform_reduce(IterTy Begin, IterTy End, ResultTy Init,
+                                   ReduceFuncTy Reduce,
+                                   TransformFuncTy Transform) {
+  size_t Size = std::distance(Begin, End);
+  if (Size == 0)
+    return Init;
+  size_t NumChunks = getNumChunks(Size);
+  std::vector<ResultTy> Results(NumChunks, Init);
+  parallel_for_each_chunk(Begin, End, NumChunks,
+                          [&](size_t Chunk, IterTy I, IterTy E) {
+                            ResultTy R = Init;
+                            for (; I != E; ++I)
+                              R = Reduce(std::move(R), Transform(*I));
+                            Results[Chunk] = std::move(R);
+                          });
+  // Combine the partial results in order, so that the result only depends on
+  // Reduce being associative.
+  ResultTy R = std::move(Results.front());
+  for (size_t I = 1; I != NumChunks; ++I)
+    R = Reduce(std::move(R), std::move(Results[I]));
+  return R;
+}
+
+template <class InIterTy, class OutIterTy, class BinaryOpTy>
+OutIterTy parallel_inclusive_scan(InIterTy Begin, InIterTy End, OutIterTy Out,
+                                  BinaryOpTy Op) {
+  using ValueTy = typename std::iterator_traits<InIterTy>::value_type;
+  size_t Size = std::distance(Begin, End);
+  if (Size == 0)
+    return Out;
+  size_t NumChunks = getNumChunks(Size);
+  std::vector<OutIterTy> ChunkEnds(NumChunks);
+
+  // Scan each chunk on its own.
+  parallel_for_each_chunk(Begin, End, NumChunks,
+                          [&](size_t Chunk, InIterTy I, InIterTy E) {
+                            OutIterTy O = Out + std::distance(Begin, I);
+                            ChunkEnds[Chunk] = std::partial_sum(I, E, O, Op);
+                          });
+
+  // The last element of every chunk is now the total of that chunk. Add the
+  // totals of all preceding chunks to the elements of each chunk.
+  std::vector<ValueTy> Carry;
+  Carry.reserve(NumChunks);
+  Carry.push_back(*(ChunkEnds[0] - 1));
+  for (size_t I = 1; I != NumChunks; ++I)
+    Carry.push_back(Op(Carry[I - 1], *(ChunkEnds[I] - 1)));
+  parallel_for_each_n(size_t(1), NumChunks, [&](size_t Chunk) {
+    for (OutIterTy O = ChunkEnds[Chunk - 1], E = ChunkEnds[Chunk]; O != E; ++O)
+      *O = Op(Carry[Chunk - 1], *O);
+  });
+  return ChunkEnds.back();
+}
+
+template <class IterTy, class TransformFuncTy, class EmitFuncTy>
+void parallel_transform_ordered(IterTy Begin, IterTy End,
+                                TransformFuncTy Transform, EmitFuncTy Emit) {
+  using ResultTy = typename std::decay<decltype(Transform(*Begin))>::type;
+  std::vector<Optional<ResultTy>> Results(std::distance(Begin, End));
+  if (Results.empty())
+    return;
+  parallel_for_each_chunk(Begin, End, getNumChunks(Results.size()),
+                          [&](size_t, IterTy I, IterTy E) {
+                            for (; I != E; ++I)
+                              Results[std::distance(Begin, I)] = Transform(*I);
+                          });
+  for (Optional<ResultTy> &R : Results)
+    Emit(std::move(*R));
+}
+
 #endif
 
 template <typename Iter>
@@ -217,6 +334,47 @@ void for_each_n(Policy policy, IndexTy Begin, IndexTy End, FuncTy Fn) {
     Fn(I);
 }
 
+/// Reduce the results of \p Transform on every element of [Begin, End) with
+/// \p Reduce, starting from \p Init. The parallel version reduces chunks of
+/// the input independently and then combines them in order, so \p Reduce
+/// must be associative and \p Init must be its identity, but the result does
+/// not depend on scheduling.
+template <class Policy, class IterTy, class ResultTy, class ReduceFuncTy,
+          class TransformFuncTy>
+ResultTy transform_reduce(Policy policy, IterTy Begin, IterTy End,
+                          ResultTy Init, ReduceFuncTy Reduce,
+                          TransformFuncTy Transform) {
+  static_assert(is_execution_policy<Policy>::value,
+                "Invalid execution policy!");
+  for (; Begin != End; ++Begin)
+    Init = Reduce(std::move(Init), Transform(*Begin));
+  return Init;
+}
+
+/// Write the running totals of [Begin, End) under the associative \p Op to
+/// \p Out, like std::partial_sum. Out may be Begin. The parallel version
+/// needs random access iterators.
+template <class Policy, class InIterTy, class OutIterTy, class BinaryOpTy>
+OutIterTy inclusive_scan(Policy policy, InIterTy Begin, InIterTy End,
+                         OutIterTy Out, BinaryOpTy Op) {
+  static_assert(is_execution_policy<Policy>::value,
+                "Invalid execution policy!");
+  return std::partial_sum(Begin, End, Out, Op);
+}
+
+/// Call \p Emit on the result of \p Transform for every element of
+/// [Begin, End), in order. The parallel version runs \p Transform
+/// concurrently and keeps all results until it calls \p Emit on the calling
+/// thread, so output written by \p Emit is deterministic.
+template <class Policy, class IterTy, class TransformFuncTy, class EmitFuncTy>
+void transform_ordered(Policy policy, IterTy Begin, IterTy End,
+                       TransformFuncTy Transform, EmitFuncTy Emit) {
+  static_assert(is_execution_policy<Policy>::value,
+                "Invalid execution policy!");
+  for (; Begin != End; ++Begin)
+    Emit(Transform(*Begin));
+}
+
 // Parallel algorithm implementations, only available when LLVM_ENABLE_THREADS
 // is true.
 #if LLVM_ENABLE_THREADS
@@ -238,6 +396,27 @@ void for_each_n(parallel_execution_policy policy, IndexTy Begin, IndexTy End,
                 FuncTy Fn) {
   detail::parallel_for_each_n(Begin, End, Fn);
 }
+
+template <class IterTy, class ResultTy, class ReduceFuncTy,
+          class TransformFuncTy>
+ResultTy transform_reduce(parallel_execution_policy policy, IterTy Begin,
+                          IterTy End, ResultTy Init, ReduceFuncTy Reduce,
+                          TransformFuncTy Transform) {
+  return detail::parallel_transform_reduce(Begin, End, std::move(Init), Reduce,
+                                           Transform);
+}
+
+template <class InIterTy, class OutIterTy, class BinaryOpTy>
+OutIterTy inclusive_scan(parallel_execution_policy policy, InIterTy Begin,
+                         InIterTy End, OutIterTy Out, BinaryOpTy Op) {
+  return detail::parallel_inclusive_scan(Begin, End, Out, Op);
+}
+
+template <class IterTy, class TransformFuncTy, class EmitFuncTy>
+void transform_ordered(parallel_execution_policy policy, IterTy Begin,
+                       IterTy End, TransformFuncTy Transform, EmitFuncTy Emit) {
+  detail::parallel_transform_ordered(Begin, End, Transform, Emit);
+}
 #endif
 
 } // namespace parallel
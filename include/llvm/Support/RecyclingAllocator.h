@@ -50,6 +50,11 @@ public:
   template<class SubClass>
   void Deallocate(SubClass* E) { return Base.Deallocate(Allocator, E); }
 
+  /// getAllocator - Return the wrapped allocator, e.g. to set the category
+  /// its memory is accounted for.
+  ///
+  AllocatorType &getAllocator() { return Allocator; }
+
   void PrintStats() {
     Allocator.PrintStats();
     Base.PrintStats();
@@ -33,6 +33,16 @@ namespace llvm {
 ///
 /// The pool keeps a vector of threads alive, waiting on a condition variable
 /// for some work to become available.
+///
+/// These threads are separate from the work-stealing workers behind
+/// llvm::parallel (see Parallel.h). Every task here gets a thread of its own
+/// once one of the ThreadCount threads is free, and tasks may block, e.g. on
+/// the caller or on each other, as the ThinLTO backends and the tests do. On
+/// the fixed set of shared workers such a task would hold a worker that
+/// parallel algorithms need, or wait forever for a task queued behind it. A
+/// process that uses both can therefore run more threads than there are
+/// cores, e.g. when pool tasks call parallel algorithms, whose tasks run on
+/// the shared workers.
 class ThreadPool {
 public:
   using TaskTy = std::function<void()>;
@@ -12,6 +12,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/MemoryAccounting.h"
 #include <cassert>
 #include <string>
 #include <utility>
@@ -28,6 +29,7 @@ class TimeRecord {
   double UserTime;       ///< User time elapsed.
   double SystemTime;     ///< System time elapsed.
   ssize_t MemUsed;       ///< Memory allocated (in bytes).
+  MemoryUsage Memory;    ///< Memory used by category, with -track-memory.
 public:
   TimeRecord() : WallTime(0), UserTime(0), SystemTime(0), MemUsed(0) {}
 
@@ -42,6 +44,11 @@ public:
   double getSystemTime() const { return SystemTime; }
   double getWallTime() const { return WallTime; }
   ssize_t getMemUsed() const { return MemUsed; }
+  const MemoryUsage &getMemoryUsage() const { return Memory; }
+
+  /// Add the memory used by category over a span of time, e.g. one run of a
+  /// pass.
+  void addMemoryUsage(const MemoryUsage &Usage) { Memory += Usage; }
 
   bool operator<(const TimeRecord &T) const {
     // Sort by Wall Time elapsed, as it is the only thing really accurate
@@ -53,12 +60,15 @@ public:
     UserTime   += RHS.UserTime;
     SystemTime += RHS.SystemTime;
     MemUsed    += RHS.MemUsed;
+    Memory     += RHS.Memory;
   }
   void operator-=(const TimeRecord &RHS) {
     WallTime   -= RHS.WallTime;
     UserTime   -= RHS.UserTime;
     SystemTime -= RHS.SystemTime;
     MemUsed    -= RHS.MemUsed;
+    // The memory usage by category is not a point in time, but is collected
+    // over a span of time already; there is nothing to subtract.
   }
 
   /// Print the current time record to \p OS, with a breakdown showing
@@ -76,6 +86,8 @@ public:
 class Timer {
   TimeRecord Time;          ///< The total time captured.
   TimeRecord StartTime;     ///< The time startTimer() was last called.
+  MemoryRegionStart MemoryStart; ///< The memory use at startTimer().
+  bool AccountingMemory = false; ///< Is the memory use being measured?
   std::string Name;         ///< The name of this time variable.
   std::string Description;  ///< Description of this time variable.
   bool Running;             ///< Is the timer currently running?
@@ -98,6 +98,10 @@ public:
   /// tell - Return the current offset with the file.
   uint64_t tell() const { return current_pos() + GetNumBytesInBuffer(); }
 
+  /// If possible, make room for \p ExtraSize more bytes of output up front, so
+  /// that the stream does not have to grow while they are written.
+  virtual void reserveExtraSpace(uint64_t ExtraSize) {}
+
   //===--------------------------------------------------------------------===//
   // Configuration Interface
   //===--------------------------------------------------------------------===//
@@ -528,6 +532,10 @@ public:
 
   ~raw_svector_ostream() override = default;
 
+  void reserveExtraSpace(uint64_t ExtraSize) override {
+    OS.reserve(tell() + ExtraSize);
+  }
+
   void flush() = delete;
 
   /// Return a StringRef for the vector contents.
@@ -137,11 +137,19 @@ public:
 /// \p ExportLists contains for each Module the set of globals (GUID) that will
 /// be imported by another module, or referenced by such a function. I.e. this
 /// is the set of globals that need to be promoted/renamed appropriately.
+///
+/// If \p ImportCachePath is not empty, the import lists are also written to
+/// that file, along with the modules and symbols each of them was computed
+/// from. The import lists a previous call wrote there are reused for modules
+/// whose list cannot have changed since, i.e. when neither the module nor
+/// any module whose summaries were considered for importing into it changed
+/// or gained new definitions. This requires module hashes in the index.
 void ComputeCrossModuleImport(
     const ModuleSummaryIndex &Index,
     const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
     StringMap<FunctionImporter::ImportMapTy> &ImportLists,
-    StringMap<FunctionImporter::ExportSetTy> &ExportLists);
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists,
+    StringRef ImportCachePath = "");
 
 /// Compute all the imports for the given module using the Index.
 ///
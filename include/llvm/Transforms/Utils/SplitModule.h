@@ -25,6 +25,12 @@ class Module;
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
 ///
+/// If BalanceByCodeSize is set, the partitions are made at function
+/// granularity and packed so that each holds roughly the same number of
+/// instructions, which evens out the work of code generating them in parallel.
+/// Otherwise globals that do not have to be kept together are distributed by
+/// a hash of their name.
+///
 /// FIXME: This function does not deal with the somewhat subtle symbol
 /// visibility issues around module splitting, including (but not limited to):
 ///
@@ -35,7 +41,7 @@ class Module;
 void SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals = false);
+    bool PreserveLocals = false, bool BalanceByCodeSize = false);
 
 } // end namespace llvm
 
@@ -181,8 +181,7 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     unsigned Code = ReadVBR(6);
     unsigned NumElts = ReadVBR(6);
-    for (unsigned i = 0; i != NumElts; ++i)
-      Vals.push_back(ReadVBR64(6));
+    ReadVBR64Array(6, NumElts, Vals);
     return Code;
   }
 
@@ -235,8 +234,7 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
           Vals.push_back(Read((unsigned)EltEnc.getEncodingData()));
         break;
       case BitCodeAbbrevOp::VBR:
-        for (; NumElts; --NumElts)
-          Vals.push_back(ReadVBR64((unsigned)EltEnc.getEncodingData()));
+        ReadVBR64Array((unsigned)EltEnc.getEncodingData(), NumElts, Vals);
         break;
       case BitCodeAbbrevOp::Char6:
         for (; NumElts; --NumElts)
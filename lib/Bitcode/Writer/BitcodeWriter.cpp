@@ -67,6 +67,8 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -86,6 +88,11 @@ static cl::opt<unsigned>
                    cl::desc("Number of metadatas above which we emit an index "
                             "to enable lazy-loading"));
 
+static cl::opt<unsigned> WriterThreads(
+    "bitcode-writer-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads used to encode function blocks. The output "
+             "does not depend on it"));
+
 cl::opt<bool> WriteRelBFToSummary(
     "write-relbf-to-summary", cl::Hidden, cl::init(false),
     cl::desc("Write relative block frequency to function summary "));
@@ -202,6 +209,17 @@ public:
               assignValueId(CallEdge.first.getGUID());
   }
 
+  /// Constructs a ModuleBitcodeWriterBase that writes function blocks of
+  /// \p M for another writer, starting from that writer's enumeration \p VE.
+  /// Only the use-list orders in \p UseListOrders are written.
+  ModuleBitcodeWriterBase(const Module &M, const ValueEnumerator &VE,
+                          UseListOrderStack UseListOrders,
+                          StringTableBuilder &StrtabBuilder,
+                          BitstreamWriter &Stream)
+      : BitcodeWriterBase(Stream, StrtabBuilder), M(M),
+        VE(VE, std::move(UseListOrders)), Index(nullptr),
+        GlobalValueId(this->VE.getValues().size()) {}
+
 protected:
   void writePerModuleGlobalValueSummary();
 
@@ -269,6 +287,18 @@ public:
         Buffer(Buffer), GenerateHash(GenerateHash), ModHash(ModHash),
         BitcodeStartBit(Stream.GetCurrentBitNo()) {}
 
+  /// Constructs a ModuleBitcodeWriter that encodes function blocks of \p M
+  /// for another writer, numbering values as that writer's \p VE does.
+  ModuleBitcodeWriter(const Module &M, const ValueEnumerator &VE,
+                      UseListOrderStack UseListOrders,
+                      SmallVectorImpl<char> &Buffer,
+                      StringTableBuilder &StrtabBuilder,
+                      BitstreamWriter &Stream)
+      : ModuleBitcodeWriterBase(M, VE, std::move(UseListOrders), StrtabBuilder,
+                                Stream),
+        Buffer(Buffer), GenerateHash(false), ModHash(nullptr),
+        BitcodeStartBit(Stream.GetCurrentBitNo()) {}
+
   /// Emit the current module to the bitstream.
   void write();
 
@@ -385,6 +415,9 @@ private:
   void
   writeFunction(const Function &F,
                 DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
+  void writeFunctionsInParallel(
+      ArrayRef<const Function *> Functions, unsigned NumThreads,
+      DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
   void writeBlockInfo();
   void writeModuleHash(size_t BlockStartPos);
 
@@ -3150,6 +3183,93 @@ void ModuleBitcodeWriter::writeFunction(
   Stream.ExitBlock();
 }
 
+// Encode the function blocks on NumThreads threads and splice them into the
+// stream in module order. Function blocks only depend on the module-level
+// value numbering and on the abbreviations from the blockinfo block. Each
+// thread starts from a copy of this writer's enumeration, takes the use-list
+// orders of its own functions, and emits the blockinfo block into its own
+// buffer to reproduce the abbreviations. The blocks produced are therefore
+// bit-identical to the ones writeFunction would emit here.
+void ModuleBitcodeWriter::writeFunctionsInParallel(
+    ArrayRef<const Function *> Functions, unsigned NumThreads,
+    DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex) {
+  struct EncodedShard {
+    ArrayRef<const Function *> Functions;
+    UseListOrderStack UseListOrders;
+    SmallVector<char, 0> Buffer;
+    // The bit positions of the first function block and of the end of the
+    // last one in Buffer.
+    uint64_t Begin = 0, End = 0;
+    DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
+  };
+
+  // Split the functions into contiguous shards of about the same number of
+  // instructions.
+  uint64_t TotalSize = 0;
+  for (const Function *F : Functions)
+    TotalSize += F->getInstructionCount();
+  std::vector<EncodedShard> Shards(NumThreads);
+  size_t Begin = 0;
+  uint64_t Size = 0;
+  for (unsigned I = 0; I != NumThreads; ++I) {
+    uint64_t Target = TotalSize * (I + 1) / NumThreads;
+    size_t End = Begin;
+    while (End != Functions.size() &&
+           (I == NumThreads - 1 || Size < Target))
+      Size += Functions[End++]->getInstructionCount();
+    Shards[I].Functions = Functions.slice(Begin, End - Begin);
+    Begin = End;
+  }
+
+  // The module-level use-list block has been written, so the stack only holds
+  // function orders, grouped by function with the first function on top.
+  // Hand each shard the slice for its functions, keeping that order.
+  if (VE.shouldPreserveUseListOrder()) {
+    DenseMap<const Function *, EncodedShard *> ShardOf;
+    for (EncodedShard &Shard : Shards)
+      for (const Function *F : Shard.Functions)
+        ShardOf[F] = &Shard;
+    for (UseListOrder &Order : VE.UseListOrders) {
+      assert(ShardOf.count(Order.F) && "Use-list order of an unknown function");
+      ShardOf[Order.F]->UseListOrders.push_back(std::move(Order));
+    }
+    VE.UseListOrders.clear();
+  }
+
+  {
+    ThreadPool Pool(NumThreads);
+    for (EncodedShard &Shard : Shards) {
+      if (Shard.Functions.empty())
+        continue;
+      EncodedShard *S = &Shard;
+      Pool.async([this, S]() {
+        StringTableBuilder ShardStrtab(StringTableBuilder::RAW);
+        BitstreamWriter ShardStream(S->Buffer);
+        ModuleBitcodeWriter Writer(M, VE, std::move(S->UseListOrders),
+                                   S->Buffer, ShardStrtab, ShardStream);
+        Writer.writeBlockInfo();
+        ShardStream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+        S->Begin = ShardStream.GetCurrentBitNo();
+        for (const Function *F : S->Functions)
+          Writer.writeFunction(*F, S->FunctionToBitcodeIndex);
+        S->End = ShardStream.GetCurrentBitNo();
+        ShardStream.ExitBlock();
+      });
+    }
+  }
+
+  for (EncodedShard &Shard : Shards) {
+    if (Shard.Functions.empty())
+      continue;
+    uint64_t Offset = Stream.GetCurrentBitNo() - Shard.Begin;
+    for (const Function *F : Shard.Functions)
+      FunctionToBitcodeIndex[F] = Shard.FunctionToBitcodeIndex[F] + Offset;
+    Stream.AppendEncodedBlocks(makeArrayRef(Shard.Buffer)
+                                   .slice(Shard.Begin / 8,
+                                          (Shard.End - Shard.Begin) / 8));
+  }
+}
+
 // Emit blockinfo, which defines the standard abbreviations etc.
 void ModuleBitcodeWriter::writeBlockInfo() {
   // We only want to emit block info records for blocks that have multiple
@@ -4089,9 +4209,20 @@ void ModuleBitcodeWriter::write() {
 
   // Emit function bodies.
   DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
-  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
-    if (!F->isDeclaration())
+  std::vector<const Function *> Functions;
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+  unsigned NumThreads = std::min<size_t>(WriterThreads, Functions.size());
+  // Function blocks encoded elsewhere can only be spliced in at a word
+  // boundary. Since the function blocks follow other blocks, that is always
+  // the case in practice.
+  if (NumThreads > 1 && Stream.GetCurrentBitNo() % 32 == 0) {
+    writeFunctionsInParallel(Functions, NumThreads, FunctionToBitcodeIndex);
+  } else {
+    for (const Function *F : Functions)
       writeFunction(*F, FunctionToBitcodeIndex);
+  }
 
   // Need to write after the above call to WriteFunction which populates
   // the summary information in the index.
@@ -4257,6 +4388,7 @@ void BitcodeWriter::writeModule(const Module &M,
                                 const ModuleSummaryIndex *Index,
                                 bool GenerateHash, ModuleHash *ModHash) {
   assert(!WroteStrtab);
+  TimeTraceScope TimeScope("WriteBitcode", M.getModuleIdentifier());
 
   // The Mods vector is used by irsymtab::build, which requires non-const
   // Modules in case it needs to materialize metadata. But the bitcode writer
@@ -4274,6 +4406,7 @@ void BitcodeWriter::writeModule(const Module &M,
 void BitcodeWriter::writeIndex(
     const ModuleSummaryIndex *Index,
     const std::map<std::string, GVSummaryMapTy> *ModuleToSummariesForIndex) {
+  TimeTraceScope TimeScope("WriteBitcodeIndex", StringRef());
   IndexBitcodeWriter IndexWriter(*Stream, StrtabBuilder, *Index,
                                  ModuleToSummariesForIndex);
   IndexWriter.write();
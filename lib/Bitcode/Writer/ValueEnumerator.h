@@ -140,6 +140,10 @@ private:
 
 public:
   ValueEnumerator(const Module &M, bool ShouldPreserveUseListOrder);
+  /// Copy the module-level enumeration of \p VE, which must not have a
+  /// function incorporated, to write function blocks on another thread.
+  /// \p UseListOrders are the orders of the functions that will be written.
+  ValueEnumerator(const ValueEnumerator &VE, UseListOrderStack UseListOrders);
   ValueEnumerator(const ValueEnumerator &) = delete;
   ValueEnumerator &operator=(const ValueEnumerator &) = delete;
 
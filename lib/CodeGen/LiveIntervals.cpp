@@ -99,6 +99,7 @@ void LiveIntervals::getAnalysisUsage(AnalysisUsage &AU) const {
 
 LiveIntervals::LiveIntervals() : MachineFunctionPass(ID) {
   initializeLiveIntervalsPass(*PassRegistry::getPassRegistry());
+  VNInfoAllocator.setMemoryCategory(MemoryCategory::LiveIntervals);
 }
 
 LiveIntervals::~LiveIntervals() {
@@ -149,6 +149,8 @@ void MachineFunction::handleRemoval(MachineInstr &MI) {
 }
 
 void MachineFunction::init() {
+  Allocator.setMemoryCategory(MemoryCategory::MachineIR);
+
   // Assume the function starts in SSA form with correct liveness.
   Properties.set(MachineFunctionProperties::Property::IsSSA);
   Properties.set(MachineFunctionProperties::Property::TracksLiveness);
@@ -994,6 +994,9 @@ SelectionDAG::SelectionDAG(const TargetMachine &tm, CodeGenOpt::Level OL)
     : TM(tm), OptLevel(OL),
       EntryNode(ISD::EntryToken, 0, DebugLoc(), getVTList(MVT::Other)),
       Root(getEntryNode()) {
+  NodeAllocator.getAllocator().setMemoryCategory(MemoryCategory::SelectionDAG);
+  OperandAllocator.setMemoryCategory(MemoryCategory::SelectionDAG);
+  Allocator.setMemoryCategory(MemoryCategory::SelectionDAG);
   InsertNode(&EntryNode);
   DbgInfo = new SDDbgInfo();
 }
@@ -29,6 +29,7 @@
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include <algorithm>
 #include <cassert>
@@ -50,6 +51,53 @@
 namespace llvm {
 namespace symbolize {
 
+/// Return the result cached for \p ModuleOffset, or compute and cache it. A
+/// null \p Cache means results are not cached.
+template <typename ResultT, typename ComputeFn>
+static ResultT lookUpCached(DenseMap<uint64_t, ResultT> *Cache,
+                            uint64_t ModuleOffset, ComputeFn Compute) {
+  // DenseMap reserves the two largest keys.
+  if (!Cache || ModuleOffset >= DenseMapInfo<uint64_t>::getTombstoneKey())
+    return Compute();
+  auto I = Cache->find(ModuleOffset);
+  if (I == Cache->end())
+    I = Cache->insert(std::make_pair(ModuleOffset, Compute())).first;
+  return I->second;
+}
+
+DILineInfo LLVMSymbolizer::resolveCode(const SymbolizableModule &Info,
+                                       uint64_t ModuleOffset) const {
+  // If the user is giving us relative addresses, add the preferred base of the
+  // object to the offset before we do the query. It's what DIContext expects.
+  if (Opts.RelativeAddresses)
+    ModuleOffset += Info.getModulePreferredBase();
+
+  DILineInfo LineInfo = Info.symbolizeCode(ModuleOffset, Opts.PrintFunctions,
+                                           Opts.UseSymbolTable);
+  if (Opts.Demangle)
+    LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, &Info);
+  return LineInfo;
+}
+
+DIInliningInfo
+LLVMSymbolizer::resolveInlinedCode(const SymbolizableModule &Info,
+                                   uint64_t ModuleOffset) const {
+  // If the user is giving us relative addresses, add the preferred base of the
+  // object to the offset before we do the query. It's what DIContext expects.
+  if (Opts.RelativeAddresses)
+    ModuleOffset += Info.getModulePreferredBase();
+
+  DIInliningInfo InlinedContext = Info.symbolizeInlinedCode(
+      ModuleOffset, Opts.PrintFunctions, Opts.UseSymbolTable);
+  if (Opts.Demangle) {
+    for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
+      auto *Frame = InlinedContext.getMutableFrame(i);
+      Frame->FunctionName = DemangleName(Frame->FunctionName, &Info);
+    }
+  }
+  return InlinedContext;
+}
+
 Expected<DILineInfo>
 LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                               uint64_t ModuleOffset, StringRef DWPName) {
@@ -64,16 +112,10 @@ LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
   if (!Info)
     return DILineInfo();
 
-  // If the user is giving us relative addresses, add the preferred base of the
-  // object to the offset before we do the query. It's what DIContext expects.
-  if (Opts.RelativeAddresses)
-    ModuleOffset += Info->getModulePreferredBase();
-
-  DILineInfo LineInfo = Info->symbolizeCode(ModuleOffset, Opts.PrintFunctions,
-                                            Opts.UseSymbolTable);
-  if (Opts.Demangle)
-    LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
-  return LineInfo;
+  if (!Opts.CacheResults)
+    return resolveCode(*Info, ModuleOffset);
+  return lookUpCached(&ResultsForModule[ModuleName].Code, ModuleOffset,
+                      [&] { return resolveCode(*Info, ModuleOffset); });
 }
 
 Expected<DIInliningInfo>
@@ -90,20 +132,99 @@ LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
   if (!Info)
     return DIInliningInfo();
 
-  // If the user is giving us relative addresses, add the preferred base of the
-  // object to the offset before we do the query. It's what DIContext expects.
-  if (Opts.RelativeAddresses)
-    ModuleOffset += Info->getModulePreferredBase();
+  if (!Opts.CacheResults)
+    return resolveInlinedCode(*Info, ModuleOffset);
+  return lookUpCached(&ResultsForModule[ModuleName].InlinedCode, ModuleOffset,
+                      [&] { return resolveInlinedCode(*Info, ModuleOffset); });
+}
 
-  DIInliningInfo InlinedContext = Info->symbolizeInlinedCode(
-      ModuleOffset, Opts.PrintFunctions, Opts.UseSymbolTable);
-  if (Opts.Demangle) {
-    for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
-      auto *Frame = InlinedContext.getMutableFrame(i);
-      Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
+template <typename ResultT, typename ResolveFn>
+std::vector<ResultT> LLVMSymbolizer::symbolizeBatch(
+    ArrayRef<ModuleAddress> Addresses,
+    function_ref<void(Error)> HandleLoadError, StringRef DWPName,
+    DenseMap<uint64_t, ResultT> CachedResults::*Cache, ResolveFn Resolve) {
+  struct ModuleBatch {
+    SymbolizableModule *Info = nullptr;
+    DenseMap<uint64_t, ResultT> *Cache = nullptr;
+    std::vector<size_t> Indices;
+  };
+
+  // Group the addresses by module. Loading modules updates the symbolizer's
+  // maps, so it is done up front on this thread.
+  std::map<StringRef, ModuleBatch> Batches;
+  for (size_t I = 0, E = Addresses.size(); I != E; ++I) {
+    auto Inserted = Batches.insert(
+        std::make_pair(Addresses[I].ModuleName, ModuleBatch()));
+    ModuleBatch &Batch = Inserted.first->second;
+    if (Inserted.second) {
+      std::string ModuleName = Addresses[I].ModuleName;
+      auto InfoOrErr = getOrCreateModuleInfo(ModuleName, DWPName);
+      if (InfoOrErr)
+        Batch.Info = *InfoOrErr;
+      else
+        HandleLoadError(InfoOrErr.takeError());
+      if (Batch.Info && Opts.CacheResults)
+        Batch.Cache = &(ResultsForModule[ModuleName].*Cache);
     }
+    // A module that failed to load, now or in an earlier call, has no info.
+    // Leave its results empty.
+    if (Batch.Info)
+      Batch.Indices.push_back(I);
   }
-  return InlinedContext;
+
+  std::vector<ResultT> Results(Addresses.size());
+  auto ResolveModule = [&](ModuleBatch *Batch) {
+    std::vector<size_t> &Indices = Batch->Indices;
+    llvm::sort(Indices, [&](size_t LHS, size_t RHS) {
+      return Addresses[LHS].ModuleOffset < Addresses[RHS].ModuleOffset;
+    });
+    for (size_t K = 0, E = Indices.size(); K != E; ++K) {
+      uint64_t ModuleOffset = Addresses[Indices[K]].ModuleOffset;
+      if (K && Addresses[Indices[K - 1]].ModuleOffset == ModuleOffset) {
+        Results[Indices[K]] = Results[Indices[K - 1]];
+        continue;
+      }
+      Results[Indices[K]] = lookUpCached(Batch->Cache, ModuleOffset, [&] {
+        return Resolve(*Batch->Info, ModuleOffset);
+      });
+    }
+  };
+
+  std::vector<ModuleBatch *> Work;
+  for (auto &KV : Batches)
+    if (!KV.second.Indices.empty())
+      Work.push_back(&KV.second);
+
+  // Each module has its own debug info context and cache, so modules can be
+  // resolved in parallel. Win32 modules may be read and demangled through
+  // DIA and DbgHelp, which are not thread-safe.
+  if (any_of(Work, [](ModuleBatch *Batch) {
+        return Batch->Info->isWin32Module();
+      }))
+    for_each(Work, ResolveModule);
+  else
+    parallel::for_each(parallel::par, Work.begin(), Work.end(), ResolveModule);
+  return Results;
+}
+
+std::vector<DILineInfo> LLVMSymbolizer::symbolizeCodeBatch(
+    ArrayRef<ModuleAddress> Addresses,
+    function_ref<void(Error)> HandleLoadError, StringRef DWPName) {
+  return symbolizeBatch(
+      Addresses, HandleLoadError, DWPName, &CachedResults::Code,
+      [this](const SymbolizableModule &Info, uint64_t ModuleOffset) {
+        return resolveCode(Info, ModuleOffset);
+      });
+}
+
+std::vector<DIInliningInfo> LLVMSymbolizer::symbolizeInlinedCodeBatch(
+    ArrayRef<ModuleAddress> Addresses,
+    function_ref<void(Error)> HandleLoadError, StringRef DWPName) {
+  return symbolizeBatch(
+      Addresses, HandleLoadError, DWPName, &CachedResults::InlinedCode,
+      [this](const SymbolizableModule &Info, uint64_t ModuleOffset) {
+        return resolveInlinedCode(Info, ModuleOffset);
+      });
 }
 
 Expected<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
@@ -132,6 +253,7 @@ Expected<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
 }
 
 void LLVMSymbolizer::flush() {
+  ResultsForModule.clear();
   ObjectForUBPathAndArch.clear();
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
@@ -7,6 +7,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
 
@@ -107,6 +109,22 @@ CompileOnDemandLayer::compileWholeModule(GlobalValueSet Requested) {
   return None;
 }
 
+CompileOnDemandLayer::GlobalValueSet
+CompileOnDemandLayer::speculateDirectCallees(const GlobalValueSet &Partition) {
+  GlobalValueSet Callees;
+  for (auto *GV : Partition) {
+    auto *F = dyn_cast<Function>(GV);
+    if (!F)
+      continue;
+    for (auto &I : instructions(F))
+      if (auto CS = ImmutableCallSite(&I))
+        if (auto *Callee = dyn_cast<Function>(
+                CS.getCalledValue()->stripPointerCasts()))
+          Callees.insert(Callee);
+  }
+  return Callees;
+}
+
 CompileOnDemandLayer::CompileOnDemandLayer(
     ExecutionSession &ES, IRLayer &BaseLayer, LazyCallThroughManager &LCTMgr,
     IndirectStubsManagerBuilder BuildIndirectStubsManager)
@@ -117,6 +135,10 @@ void CompileOnDemandLayer::setPartitionFunction(PartitionFunction Partition) {
   this->Partition = std::move(Partition);
 }
 
+void CompileOnDemandLayer::setSpeculateFunction(SpeculateFunction Speculate) {
+  this->Speculate = std::move(Speculate);
+}
+
 void CompileOnDemandLayer::emit(MaterializationResponsibility R,
                                 ThreadSafeModule TSM) {
   assert(TSM.getModule() && "Null module");
@@ -161,8 +183,24 @@ void CompileOnDemandLayer::emit(MaterializationResponsibility R,
                           std::move(Callables)));
 }
 
+Error CompileOnDemandLayer::redirect(JITDylib &ImplD, StringRef Name,
+                                     JITTargetAddress NewAddr) {
+  std::lock_guard<std::mutex> Lock(CODLayerMutex);
+  for (auto &KV : DylibResources) {
+    if (&KV.second.getImplDylib() != &ImplD)
+      continue;
+    auto &ISMgr = KV.second.getISManager();
+    if (!ISMgr.findStub(Name, false))
+      return Error::success();
+    return ISMgr.updatePointer(Name, NewAddr);
+  }
+  return make_error<StringError>("No stubs for " + ImplD.getName(),
+                                 inconvertibleErrorCode());
+}
+
 CompileOnDemandLayer::PerDylibResources &
 CompileOnDemandLayer::getPerDylibResources(JITDylib &TargetD) {
+  std::lock_guard<std::mutex> Lock(CODLayerMutex);
   auto I = DylibResources.find(&TargetD);
   if (I == DylibResources.end()) {
     auto &ImplD = getExecutionSession().createJITDylib(
@@ -291,12 +329,63 @@ void CompileOnDemandLayer::emitPartition(
     return GVsToExtract->count(&GV);
   };
 
+  SymbolNameSet SpeculativeSymbols;
+  if (Speculate)
+    SpeculativeSymbols =
+        getSpeculativeSymbols(R, *TSM.getModule(), *GVsToExtract);
+
   auto ExtractedTSM = extractSubModule(TSM, ".submodule", ShouldExtract);
   R.replace(llvm::make_unique<PartitioningIRMaterializationUnit>(
       ES, std::move(TSM), R.getVModuleKey(), *this));
 
+  // Now that the rest of the module is back in the impl dylib, start on the
+  // functions this partition is likely to call before compiling it.
+  if (!SpeculativeSymbols.empty())
+    speculate(R.getTargetJITDylib(), std::move(SpeculativeSymbols));
+
   BaseLayer.emit(std::move(R), std::move(ExtractedTSM));
 }
 
+SymbolNameSet CompileOnDemandLayer::getSpeculativeSymbols(
+    const MaterializationResponsibility &R, const Module &M,
+    const GlobalValueSet &Partition) {
+  auto RequestedSymbols = R.getRequestedSymbols();
+  std::lock_guard<std::mutex> Lock(CODLayerMutex);
+
+  // Only speculate one call deep from the functions that were actually
+  // called, rather than compiling everything reachable from them.
+  if (llvm::all_of(RequestedSymbols, [&](const SymbolStringPtr &Name) {
+        return Speculated.count(Name);
+      }))
+    return SymbolNameSet();
+
+  MangleAndInterner Mangle(getExecutionSession(), M.getDataLayout());
+  SymbolNameSet Names;
+  for (auto *GV : Speculate(Partition)) {
+    // Symbols have been promoted by now, so anything with a body has a name
+    // in the impl dylib.
+    if (!isa<Function>(GV) || GV->isDeclaration() || Partition.count(GV))
+      continue;
+    auto Name = Mangle(GV->getName());
+    if (Speculated.insert(Name).second)
+      Names.insert(std::move(Name));
+  }
+  return Names;
+}
+
+void CompileOnDemandLayer::speculate(JITDylib &ImplD, SymbolNameSet Names) {
+  auto &ES = getExecutionSession();
+  ES.lookup(JITDylibSearchList({{&ImplD, true}}), std::move(Names),
+            [&ES](Expected<SymbolMap> Result) {
+              if (!Result)
+                ES.reportError(Result.takeError());
+            },
+            [&ES](Error Err) {
+              if (Err)
+                ES.reportError(std::move(Err));
+            },
+            NoDependenciesToRegister);
+}
+
 } // end namespace orc
 } // end namespace llvm
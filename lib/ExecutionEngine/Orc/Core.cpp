@@ -13,6 +13,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
 
 #if LLVM_ENABLE_THREADS
 #include <future>
@@ -1577,6 +1578,31 @@ ExecutionSession::ExecutionSession(std::shared_ptr<SymbolStringPool> SSP)
   JDs.push_back(std::unique_ptr<JITDylib>(new JITDylib(*this, "<main>")));
 }
 
+ExecutionSession::~ExecutionSession() { waitForMaterializationThreads(); }
+
+ExecutionSession &
+ExecutionSession::setNumMaterializationThreads(unsigned NumThreads) {
+  assert(NumThreads != 0 && "Materialization thread pool can not be empty");
+#if LLVM_ENABLE_THREADS
+  waitForMaterializationThreads();
+  MaterializationThreads = llvm::make_unique<ThreadPool>(NumThreads);
+  DispatchMaterialization = [this](JITDylib &JD,
+                                   std::unique_ptr<MaterializationUnit> MU) {
+    // FIXME: Switch to move capture once we have c++14.
+    auto SharedMU = std::shared_ptr<MaterializationUnit>(std::move(MU));
+    MaterializationThreads->async([SharedMU, &JD]() {
+      SharedMU->doMaterialize(JD);
+    });
+  };
+#endif
+  return *this;
+}
+
+void ExecutionSession::waitForMaterializationThreads() {
+  if (MaterializationThreads)
+    MaterializationThreads->wait();
+}
+
 JITDylib &ExecutionSession::getMainJITDylib() {
   return runSessionLocked([this]() -> JITDylib & { return *JDs.front(); });
 }
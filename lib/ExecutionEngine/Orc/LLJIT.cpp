@@ -13,15 +13,24 @@
 
 namespace {
 
-  // A SimpleCompiler that owns its TargetMachine.
+  // A SimpleCompiler that owns its TargetMachine, and uses the ObjectCache
+  // currently set on the JIT.
   class TMOwningSimpleCompiler : public llvm::orc::SimpleCompiler {
   public:
-    TMOwningSimpleCompiler(std::unique_ptr<llvm::TargetMachine> TM)
-      : llvm::orc::SimpleCompiler(*TM), TM(std::move(TM)) {}
+    TMOwningSimpleCompiler(std::unique_ptr<llvm::TargetMachine> TM,
+                           llvm::ObjectCache *const &ObjCache)
+      : llvm::orc::SimpleCompiler(*TM), TM(std::move(TM)),
+        CurrentObjCache(ObjCache) {}
+
+    CompileResult operator()(llvm::Module &M) {
+      setObjectCache(CurrentObjCache);
+      return SimpleCompiler::operator()(M);
+    }
   private:
     // FIXME: shared because std::functions (and thus
     // IRCompileLayer::CompileFunction) are not moveable.
     std::shared_ptr<llvm::TargetMachine> TM;
+    llvm::ObjectCache *const &CurrentObjCache;
   };
 
 } // end anonymous namespace
@@ -30,8 +39,9 @@ namespace llvm {
 namespace orc {
 
 LLJIT::~LLJIT() {
-  if (CompileThreads)
-    CompileThreads->wait();
+  // The compile threads use the layers, which are destroyed before the
+  // session.
+  ES->waitForMaterializationThreads();
 }
 
 Expected<std::unique_ptr<LLJIT>>
@@ -81,21 +91,28 @@ Expected<JITEvaluatedSymbol> LLJIT::lookupLinkerMangled(JITDylib &JD,
 LLJIT::LLJIT(std::unique_ptr<ExecutionSession> ES,
              std::unique_ptr<TargetMachine> TM, DataLayout DL)
     : ES(std::move(ES)), Main(this->ES->getMainJITDylib()), DL(std::move(DL)),
-      ObjLinkingLayer(
-          *this->ES,
-          []() { return llvm::make_unique<SectionMemoryManager>(); }),
+      ObjLinkingLayer(*this->ES,
+                      [this]() {
+                        return llvm::make_unique<SectionMemoryManager>(
+                            &MemMapper);
+                      }),
       CompileLayer(*this->ES, ObjLinkingLayer,
-                   TMOwningSimpleCompiler(std::move(TM))),
+                   TMOwningSimpleCompiler(std::move(TM), ObjCache)),
       CtorRunner(Main), DtorRunner(Main) {}
 
 LLJIT::LLJIT(std::unique_ptr<ExecutionSession> ES, JITTargetMachineBuilder JTMB,
              DataLayout DL, unsigned NumCompileThreads)
     : ES(std::move(ES)), Main(this->ES->getMainJITDylib()), DL(std::move(DL)),
-      ObjLinkingLayer(
-          *this->ES,
-          []() { return llvm::make_unique<SectionMemoryManager>(); }),
+      ObjLinkingLayer(*this->ES,
+                      [this]() {
+                        return llvm::make_unique<SectionMemoryManager>(
+                            &MemMapper);
+                      }),
       CompileLayer(*this->ES, ObjLinkingLayer,
-                   ConcurrentIRCompiler(std::move(JTMB))),
+                   [this, JTMB](Module &M) {
+                     ConcurrentIRCompiler Compile(JTMB, ObjCache);
+                     return Compile(M);
+                   }),
       CtorRunner(Main), DtorRunner(Main) {
   assert(NumCompileThreads != 0 &&
          "Multithreaded LLJIT instance can not be created with 0 threads");
@@ -104,16 +121,7 @@ LLJIT::LLJIT(std::unique_ptr<ExecutionSession> ES, JITTargetMachineBuilder JTMB,
   // them in parallel.
   CompileLayer.setCloneToNewContextOnEmit(true);
 
-  // Create a thread pool to compile on and set the execution session
-  // dispatcher to use the thread pool.
-  CompileThreads = llvm::make_unique<ThreadPool>(NumCompileThreads);
-  this->ES->setDispatchMaterialization(
-      [this](JITDylib &JD, std::unique_ptr<MaterializationUnit> MU) {
-        // FIXME: Switch to move capture once we have c++14.
-        auto SharedMU = std::shared_ptr<MaterializationUnit>(std::move(MU));
-        auto Work = [SharedMU, &JD]() { SharedMU->doMaterialize(JD); };
-        CompileThreads->async(std::move(Work));
-      });
+  this->ES->setNumMaterializationThreads(NumCompileThreads);
 }
 
 std::string LLJIT::mangle(StringRef UnmangledName) {
@@ -173,6 +181,35 @@ LLLazyJIT::Create(JITTargetMachineBuilder JTMB, DataLayout DL,
       std::move(*LCTMgr), std::move(ISMBuilder)));
 }
 
+LLLazyJIT::~LLLazyJIT() {
+  // The compile threads use the layers, which are destroyed before LLJIT's
+  // destructor runs.
+  ES->waitForMaterializationThreads();
+}
+
+Error LLLazyJIT::enableTieredCompilation(
+    unsigned Threshold, IRTransformLayer::TransformFunction Transform,
+    CodeGenOpt::Level OptLevel) {
+  assert(!TierUpCompileLayer && "Tiered compilation already enabled");
+
+  if (!TierUpJTMB)
+    return make_error<StringError>(
+        "Tiered compilation requires compile threads",
+        inconvertibleErrorCode());
+
+  TierUpJTMB->setCodeGenOptLevel(OptLevel);
+  TierUpCompileLayer = llvm::make_unique<IRCompileLayer>(
+      *ES, ObjLinkingLayer, ConcurrentIRCompiler(std::move(*TierUpJTMB)));
+  TierUpTransformLayer = llvm::make_unique<IRTransformLayer>(
+      *ES, *TierUpCompileLayer, std::move(Transform));
+  TierUp.enable(Threshold, *TierUpTransformLayer,
+                [this](JITDylib &ImplD, StringRef Name,
+                       JITTargetAddress NewAddr) {
+                  return CODLayer.redirect(ImplD, Name, NewAddr);
+                });
+  return Error::success();
+}
+
 Error LLLazyJIT::addLazyIRModule(JITDylib &JD, ThreadSafeModule TSM) {
   assert(TSM && "Can not add null module");
 
@@ -190,19 +227,23 @@ LLLazyJIT::LLLazyJIT(
     std::function<std::unique_ptr<IndirectStubsManager>()> ISMBuilder)
     : LLJIT(std::move(ES), std::move(TM), std::move(DL)),
       LCTMgr(std::move(LCTMgr)), TransformLayer(*this->ES, CompileLayer),
-      CODLayer(*this->ES, TransformLayer, *this->LCTMgr,
-               std::move(ISMBuilder)) {}
+      TierUp(*this->ES, TransformLayer),
+      CODLayer(*this->ES, TierUp, *this->LCTMgr, std::move(ISMBuilder)) {}
 
 LLLazyJIT::LLLazyJIT(
     std::unique_ptr<ExecutionSession> ES, JITTargetMachineBuilder JTMB,
     DataLayout DL, unsigned NumCompileThreads,
     std::unique_ptr<LazyCallThroughManager> LCTMgr,
     std::function<std::unique_ptr<IndirectStubsManager>()> ISMBuilder)
-    : LLJIT(std::move(ES), std::move(JTMB), std::move(DL), NumCompileThreads),
+    : LLJIT(std::move(ES), JTMB, std::move(DL), NumCompileThreads),
       LCTMgr(std::move(LCTMgr)), TransformLayer(*this->ES, CompileLayer),
-      CODLayer(*this->ES, TransformLayer, *this->LCTMgr,
-               std::move(ISMBuilder)) {
+      TierUp(*this->ES, TransformLayer),
+      CODLayer(*this->ES, TierUp, *this->LCTMgr, std::move(ISMBuilder)),
+      TierUpJTMB(std::move(JTMB)) {
   CODLayer.setCloneToNewContextOnEmit(true);
+
+  // With threads to spare, compile likely callees before they are called.
+  CODLayer.setSpeculateFunction(CompileOnDemandLayer::speculateDirectCallees);
 }
 
 } // End namespace orc.
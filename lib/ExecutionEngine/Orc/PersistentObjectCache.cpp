@@ -0,0 +1,123 @@
+//===--- PersistentObjectCache.cpp - On-disk cache of JIT'd objects -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/Orc/PersistentObjectCache.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::orc;
+
+// The compiler revision and the code generation settings of JTMB.
+static std::string getTargetKey(const JITTargetMachineBuilder &JTMB) {
+  std::string Key;
+  raw_string_ostream OS(Key);
+  OS << LLVM_VERSION_STRING << '\0' << JTMB.getTargetTriple().str() << '\0'
+     << JTMB.getCPU() << '\0' << JTMB.getFeatures().getString() << '\0';
+  OS << (JTMB.getRelocationModel() ? int(*JTMB.getRelocationModel()) : -1)
+     << ',' << (JTMB.getCodeModel() ? int(*JTMB.getCodeModel()) : -1) << ','
+     << int(JTMB.getCodeGenOptLevel());
+  // FIXME: Hash more of TargetOptions. These are the ones JIT clients
+  // commonly change.
+  const TargetOptions &Options = JTMB.getOptions();
+  OS << ',' << Options.EmulatedTLS << Options.ExplicitEmulatedTLS
+     << Options.RelaxELFRelocations << Options.FunctionSections
+     << Options.DataSections << Options.UnsafeFPMath << Options.NoInfsFPMath
+     << Options.NoNaNsFPMath << ',' << int(Options.FloatABIType) << ','
+     << int(Options.AllowFPOpFusion) << ',' << int(Options.ThreadModel) << ','
+     << int(Options.ExceptionModel);
+  return OS.str();
+}
+
+Expected<std::unique_ptr<PersistentObjectCache>>
+PersistentObjectCache::Create(StringRef CacheDir,
+                              const JITTargetMachineBuilder &JTMB,
+                              CachePruningPolicy Policy) {
+  if (std::error_code EC = sys::fs::create_directories(CacheDir))
+    return errorCodeToError(EC);
+
+  std::unique_ptr<PersistentObjectCache> Cache(new PersistentObjectCache(
+      CacheDir, getTargetKey(JTMB), std::move(Policy)));
+  Cache->prune();
+  return std::move(Cache);
+}
+
+bool PersistentObjectCache::prune() { return pruneCache(CacheDir, Policy); }
+
+std::string PersistentObjectCache::getEntryPath(const Module &M) {
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream OS(Bitcode);
+    WriteBitcodeToFile(M, OS);
+  }
+  SHA1 Hasher;
+  Hasher.update(TargetKey);
+  Hasher.update(StringRef(Bitcode.data(), Bitcode.size()));
+
+  // This choice of file name allows the cache to be pruned (see pruneCache()
+  // in include/llvm/Support/CachePruning.h).
+  SmallString<128> EntryPath;
+  sys::path::append(EntryPath, CacheDir,
+                    "llvmcache-" + toHex(Hasher.result()) + ".o");
+  return EntryPath.str();
+}
+
+std::unique_ptr<MemoryBuffer>
+PersistentObjectCache::getObject(const Module *M) {
+  std::string EntryPath = getEntryPath(*M);
+
+  int FD;
+  if (!sys::fs::openFileForRead(EntryPath, FD, sys::fs::OF_UpdateAtime)) {
+    auto MBOrErr = MemoryBuffer::getOpenFile(FD, EntryPath, /*FileSize*/ -1,
+                                             /*RequiresNullTerminator*/ false);
+    sys::Process::SafelyCloseFileDescriptor(FD);
+    if (MBOrErr)
+      return std::move(*MBOrErr);
+  }
+
+  std::lock_guard<std::mutex> Lock(PendingMutex);
+  Pending[M] = std::move(EntryPath);
+  return nullptr;
+}
+
+void PersistentObjectCache::notifyObjectCompiled(const Module *M,
+                                                 MemoryBufferRef Obj) {
+  std::string EntryPath;
+  {
+    std::lock_guard<std::mutex> Lock(PendingMutex);
+    auto I = Pending.find(M);
+    if (I == Pending.end())
+      return;
+    EntryPath = std::move(I->second);
+    Pending.erase(I);
+  }
+
+  // Failing to cache an object is not an error: it will just be compiled
+  // again next time.
+  auto Temp = sys::fs::TempFile::create(CacheDir + "/JIT-%%%%%%.tmp.o");
+  if (!Temp) {
+    consumeError(Temp.takeError());
+    return;
+  }
+  {
+    raw_fd_ostream OS(Temp->FD, /*shouldClose*/ false);
+    OS << Obj.getBuffer();
+  }
+  // On POSIX systems, this atomically replaces an entry written by another
+  // process in the meantime.
+  consumeError(Temp->keep(EntryPath));
+}
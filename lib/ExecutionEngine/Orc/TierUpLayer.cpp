@@ -0,0 +1,269 @@
+//===------- TierUpLayer.cpp - Recompile hot code in the background -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/Orc/TierUpLayer.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/ExecutionEngine/Orc/Core.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Mangler.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::orc;
+
+static bool canTierUp(const Module &M) {
+  if (!M.alias_empty() || !M.ifunc_empty())
+    return false;
+  bool HasFunctions = false;
+  for (auto &GV : M.global_values()) {
+    if (GV.isDeclaration())
+      continue;
+    // The copy refers to the first tier's globals by name.
+    if (GV.hasLocalLinkage() || !GV.hasName())
+      return false;
+    HasFunctions |= isa<Function>(GV);
+  }
+  return HasFunctions;
+}
+
+/// Count entries to each function in M, and call Callback(Ctx) on the
+/// Threshold'th.
+static void addEntryCounters(Module &M, unsigned Threshold,
+                             void (*Callback)(void *), void *Ctx) {
+  LLVMContext &C = M.getContext();
+  auto *IntPtrTy = M.getDataLayout().getIntPtrType(C);
+  auto *Int32Ty = Type::getInt32Ty(C);
+  auto *CallbackTy =
+      FunctionType::get(Type::getVoidTy(C), Type::getInt8PtrTy(C), false);
+  auto *CallbackAddr = ConstantExpr::getIntToPtr(
+      ConstantInt::get(IntPtrTy, reinterpret_cast<uintptr_t>(Callback)),
+      CallbackTy->getPointerTo());
+  auto *CtxAddr = ConstantExpr::getIntToPtr(
+      ConstantInt::get(IntPtrTy, reinterpret_cast<uintptr_t>(Ctx)),
+      Type::getInt8PtrTy(C));
+  auto *Counter =
+      new GlobalVariable(M, Int32Ty, false, GlobalValue::InternalLinkage,
+                         ConstantInt::get(Int32Ty, 0), "__orc_tier_up_count");
+
+  for (auto &F : M) {
+    if (F.isDeclaration() || F.hasFnAttribute(Attribute::Naked))
+      continue;
+
+    // Keep static allocas in the entry block.
+    BasicBlock &Entry = F.getEntryBlock();
+    auto InsertPt = Entry.getFirstInsertionPt();
+    while (isa<AllocaInst>(*InsertPt))
+      ++InsertPt;
+    BasicBlock *Body = Entry.splitBasicBlock(InsertPt, "tierup.cont");
+    Entry.getTerminator()->eraseFromParent();
+    BasicBlock *Hot = BasicBlock::Create(C, "tierup", &F, Body);
+
+    IRBuilder<> B(&Entry);
+    Value *Count = B.CreateAtomicRMW(AtomicRMWInst::Add, Counter,
+                                     B.getInt32(1), AtomicOrdering::Monotonic);
+    B.CreateCondBr(B.CreateICmpEQ(Count, B.getInt32(Threshold - 1)), Hot, Body);
+    B.SetInsertPoint(Hot);
+    B.CreateCall(CallbackAddr, CtxAddr);
+    B.CreateBr(Body);
+  }
+}
+
+static std::string getCopyName(StringRef Name) {
+  return (Name + ".tierup").str();
+}
+
+/// Rename the copy's functions, and turn its variables into references to the
+/// first tier's. Constants keep their initializers for the optimizer.
+static void prepareCopy(Module &M) {
+  M.setModuleIdentifier(getCopyName(M.getModuleIdentifier()));
+  for (auto &F : M) {
+    if (F.isDeclaration())
+      continue;
+    F.setName(getCopyName(F.getName()));
+    F.setLinkage(GlobalValue::ExternalLinkage);
+    F.setComdat(nullptr);
+  }
+  for (auto I = M.global_begin(), E = M.global_end(); I != E;) {
+    GlobalVariable &GV = *I++;
+    if (GV.isDeclaration())
+      continue;
+    if (GV.hasAppendingLinkage()) {
+      GV.eraseFromParent();
+      continue;
+    }
+    GV.setComdat(nullptr);
+    if (GV.isConstant() && !GV.isInterposable())
+      GV.setLinkage(GlobalValue::AvailableExternallyLinkage);
+    else {
+      GV.setInitializer(nullptr);
+      GV.setLinkage(GlobalValue::ExternalLinkage);
+    }
+  }
+}
+
+namespace {
+
+/// Parses a candidate's bitcode and emits the copy made from it, so that the
+/// copy's IR only exists once it is being compiled.
+class TierUpMaterializationUnit : public MaterializationUnit {
+public:
+  TierUpMaterializationUnit(IRLayer &BaseLayer, StringRef ModuleName,
+                            SmallVector<char, 0> Bitcode,
+                            SymbolFlagsMap Symbols, VModuleKey K)
+      : MaterializationUnit(std::move(Symbols), std::move(K)),
+        BaseLayer(BaseLayer), Name(getCopyName(ModuleName)),
+        Bitcode(std::move(Bitcode)) {}
+
+  StringRef getName() const override { return Name; }
+
+private:
+  void materialize(MaterializationResponsibility R) override {
+    ThreadSafeContext TSCtx(llvm::make_unique<LLVMContext>());
+    auto M = parseBitcodeFile(
+        MemoryBufferRef(StringRef(Bitcode.data(), Bitcode.size()), Name),
+        *TSCtx.getContext());
+    if (!M) {
+      R.getTargetJITDylib().getExecutionSession().reportError(M.takeError());
+      R.failMaterialization();
+      return;
+    }
+    Bitcode.clear();
+    prepareCopy(**M);
+    BaseLayer.emit(std::move(R),
+                   ThreadSafeModule(std::move(*M), std::move(TSCtx)));
+  }
+
+  void discard(const JITDylib &JD, const SymbolStringPtr &Name) override {}
+
+  IRLayer &BaseLayer;
+  std::string Name;
+  SmallVector<char, 0> Bitcode;
+};
+
+} // end anonymous namespace
+
+TierUpLayer::TierUpLayer(ExecutionSession &ES, IRLayer &BaseLayer)
+    : IRLayer(ES), BaseLayer(BaseLayer) {}
+
+void TierUpLayer::enable(unsigned Threshold, IRLayer &TierUpBaseLayer,
+                         RedirectFunction Redirect) {
+  assert(Threshold != 0 && "Tier-up threshold can not be zero");
+  this->Threshold = Threshold;
+  this->TierUpBaseLayer = &TierUpBaseLayer;
+  this->Redirect = std::move(Redirect);
+}
+
+void TierUpLayer::emit(MaterializationResponsibility R, ThreadSafeModule TSM) {
+  assert(TSM.getModule() && "Module must not be null");
+
+  if (!TierUpBaseLayer || !canTierUp(*TSM.getModule())) {
+    BaseLayer.emit(std::move(R), std::move(TSM));
+    return;
+  }
+
+  auto C = llvm::make_unique<Candidate>();
+  C->Layer = this;
+  C->JD = &R.getTargetJITDylib();
+
+  // Keep the module as it is now, before the counters go in, as bitcode: the
+  // copy is only made if the module gets hot.
+  auto &M = *TSM.getModule();
+  C->ModuleName = M.getModuleIdentifier();
+  {
+    raw_svector_ostream OS(C->Bitcode);
+    WriteBitcodeToFile(M, OS);
+  }
+  MangleAndInterner Mangle(getExecutionSession(), M.getDataLayout());
+  for (auto &F : M) {
+    if (F.isDeclaration())
+      continue;
+    auto CopyName = Mangle(getCopyName(F.getName()));
+    JITSymbolFlags Flags = JITSymbolFlags::Callable;
+    if (!F.hasHiddenVisibility())
+      Flags |= JITSymbolFlags::Exported;
+    C->CopySymbols[CopyName] = Flags;
+    C->Functions.push_back(std::make_pair(Mangle(F.getName()), CopyName));
+  }
+
+  addEntryCounters(*TSM.getModule(), Threshold, tierUp, C.get());
+  {
+    std::lock_guard<std::mutex> Lock(LayerMutex);
+    Candidates.push_back(std::move(C));
+  }
+  BaseLayer.emit(std::move(R), std::move(TSM));
+}
+
+void TierUpLayer::tierUp(void *Ctx) {
+  auto &C = *static_cast<Candidate *>(Ctx);
+  if (!C.Started.exchange(true))
+    C.Layer->emitTierUp(C);
+}
+
+void TierUpLayer::emitTierUp(Candidate &C) {
+  // The candidate stays behind for the first tier's counters to point at, but
+  // the rest of its state is only needed until the stubs are redirected.
+  auto Functions = std::make_shared<
+      std::vector<std::pair<SymbolStringPtr, SymbolStringPtr>>>(
+      std::move(C.Functions));
+  JITDylib *JD = C.JD;
+
+  auto &ES = getExecutionSession();
+  auto &TierUpJD = getTierUpDylib(*JD);
+  if (auto Err = TierUpJD.define(llvm::make_unique<TierUpMaterializationUnit>(
+          *TierUpBaseLayer, C.ModuleName, std::move(C.Bitcode),
+          std::move(C.CopySymbols), ES.allocateVModule()))) {
+    ES.reportError(std::move(Err));
+    return;
+  }
+
+  // Compile the copy on the materialization threads, and redirect the stubs
+  // once it is ready to run.
+  SymbolNameSet Names;
+  for (auto &KV : *Functions)
+    Names.insert(KV.second);
+  auto Resolved = std::make_shared<SymbolMap>();
+  ES.lookup(JITDylibSearchList({{&TierUpJD, true}}), std::move(Names),
+            [&ES, Resolved](Expected<SymbolMap> Result) {
+              if (Result)
+                *Resolved = std::move(*Result);
+              else
+                ES.reportError(Result.takeError());
+            },
+            [this, &ES, JD, Functions, Resolved](Error Err) {
+              if (Err) {
+                ES.reportError(std::move(Err));
+                return;
+              }
+              for (auto &KV : *Functions)
+                if (auto RedirectErr =
+                        Redirect(*JD, *KV.first,
+                                 (*Resolved)[KV.second].getAddress()))
+                  ES.reportError(std::move(RedirectErr));
+              Functions->clear();
+              Resolved->clear();
+            },
+            NoDependenciesToRegister);
+}
+
+JITDylib &TierUpLayer::getTierUpDylib(JITDylib &JD) {
+  std::lock_guard<std::mutex> Lock(LayerMutex);
+  auto I = TierUpDylibs.find(&JD);
+  if (I != TierUpDylibs.end())
+    return *I->second;
+
+  // Resolve the copies' references the way the first tier's are resolved.
+  auto &TierUpJD = getExecutionSession().createJITDylib(
+      JD.getName() + ".tierup", false);
+  JD.withSearchOrderDo([&](const JITDylibSearchList &SearchOrder) {
+    TierUpJD.setSearchOrder(SearchOrder, true);
+  });
+  TierUpDylibs[&JD] = &TierUpJD;
+  return TierUpJD;
+}
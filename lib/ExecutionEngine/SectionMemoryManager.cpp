@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Process.h"
@@ -194,9 +195,29 @@ static sys::MemoryBlock trimBlockToPageSize(sys::MemoryBlock M) {
 std::error_code
 SectionMemoryManager::applyMemoryGroupPermissions(MemoryGroup &MemGroup,
                                                   unsigned Permissions) {
-  for (sys::MemoryBlock &MB : MemGroup.PendingMem)
-    if (std::error_code EC = MMapper.protectMappedMemory(MB, Permissions))
+  static const size_t PageSize = sys::Process::getPageSize();
+
+  // Protect runs of blocks whose pages touch or overlap with one call each.
+  // The pages in between are the same ones the calls per block would cover.
+  SmallVector<sys::MemoryBlock, 16> Blocks(MemGroup.PendingMem.begin(),
+                                           MemGroup.PendingMem.end());
+  llvm::sort(Blocks, [](const sys::MemoryBlock &LHS,
+                        const sys::MemoryBlock &RHS) {
+    return LHS.base() < RHS.base();
+  });
+  for (size_t I = 0, E = Blocks.size(); I != E;) {
+    uintptr_t Start = (uintptr_t)Blocks[I].base();
+    uintptr_t End = Start + Blocks[I].size();
+    for (++I; I != E; ++I) {
+      uintptr_t NextStart = (uintptr_t)Blocks[I].base();
+      if (NextStart - NextStart % PageSize > alignTo(End, PageSize))
+        break;
+      End = std::max(End, NextStart + Blocks[I].size());
+    }
+    if (std::error_code EC = MMapper.protectMappedMemory(
+            sys::MemoryBlock((void *)Start, End - Start), Permissions))
       return EC;
+  }
 
   MemGroup.PendingMem.clear();
 
@@ -265,4 +286,141 @@ DefaultMMapper DefaultMMapperInstance;
 SectionMemoryManager::SectionMemoryManager(MemoryMapper *MM)
     : MMapper(MM ? *MM : DefaultMMapperInstance) {}
 
+PooledMemoryMapper::PooledMemoryMapper(size_t SlabSize, bool HugePagesForCode)
+    : SlabSize(SlabSize), HugePagesForCode(HugePagesForCode) {}
+
+PooledMemoryMapper::~PooledMemoryMapper() {
+  for (Pool *P : {&CodePool, &DataPool})
+    for (sys::MemoryBlock &Slab : P->Slabs)
+      sys::Memory::releaseMappedMemory(Slab);
+}
+
+void PooledMemoryMapper::setHugePagesForCode(bool HugePagesForCode) {
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+  this->HugePagesForCode = HugePagesForCode;
+}
+
+sys::MemoryBlock PooledMemoryMapper::allocateMappedMemory(
+    SectionMemoryManager::AllocationPurpose Purpose, size_t NumBytes,
+    const sys::MemoryBlock *const NearBlock, unsigned Flags,
+    std::error_code &EC) {
+  EC = std::error_code();
+  if (NumBytes == 0)
+    return sys::MemoryBlock();
+
+  static const size_t PageSize = sys::Process::getPageSize();
+  NumBytes = alignTo(NumBytes, PageSize);
+
+  sys::MemoryBlock Result;
+  {
+    std::lock_guard<std::mutex> Lock(PoolMutex);
+    Pool &P = getPool(Purpose);
+
+    // Extend NearBlock if possible, or else take the lowest free range that
+    // is large enough.
+    auto I = P.Free.end();
+    if (NearBlock && NearBlock->base())
+      I = P.Free.find(
+          alignTo((uintptr_t)NearBlock->base() + NearBlock->size(), PageSize));
+    if (I == P.Free.end() || I->second < NumBytes)
+      I = find_if(P.Free, [&](const std::pair<const uintptr_t, size_t> &R) {
+        return R.second >= NumBytes;
+      });
+
+    if (I == P.Free.end()) {
+      unsigned SlabFlags = sys::Memory::MF_READ | sys::Memory::MF_WRITE;
+      if (Purpose == SectionMemoryManager::AllocationPurpose::Code &&
+          HugePagesForCode)
+        SlabFlags |= sys::Memory::MF_HUGE_PAGE;
+      sys::MemoryBlock Slab = sys::Memory::allocateMappedMemory(
+          std::max(SlabSize, NumBytes), nullptr, SlabFlags, EC);
+      if (EC)
+        return sys::MemoryBlock();
+      P.Slabs.push_back(Slab);
+      I = P.Free.insert(std::make_pair((uintptr_t)Slab.base(), Slab.size()))
+              .first;
+    }
+
+    uintptr_t Addr = I->first;
+    size_t Remaining = I->second - NumBytes;
+    P.Free.erase(I);
+    if (Remaining)
+      P.Free[Addr + NumBytes] = Remaining;
+    Result = sys::MemoryBlock((void *)Addr, NumBytes);
+  }
+
+  // Free memory is kept read-write.
+  if ((Flags & sys::Memory::MF_RWE_MASK) !=
+      (sys::Memory::MF_READ | sys::Memory::MF_WRITE)) {
+    EC = sys::Memory::protectMappedMemory(Result, Flags);
+    if (EC) {
+      releaseMappedMemory(Result);
+      return sys::MemoryBlock();
+    }
+  }
+  return Result;
+}
+
+std::error_code
+PooledMemoryMapper::protectMappedMemory(const sys::MemoryBlock &Block,
+                                        unsigned Flags) {
+  return sys::Memory::protectMappedMemory(Block, Flags);
+}
+
+std::error_code PooledMemoryMapper::releaseMappedMemory(sys::MemoryBlock &M) {
+  if (!M.base() || M.size() == 0)
+    return std::error_code();
+
+  if (std::error_code EC = sys::Memory::protectMappedMemory(
+          M, sys::Memory::MF_READ | sys::Memory::MF_WRITE))
+    return EC;
+
+  uintptr_t Start = (uintptr_t)M.base();
+  size_t Size = M.size();
+  auto InSlab = [&](const sys::MemoryBlock &Slab) {
+    return (uintptr_t)Slab.base() <= Start &&
+           Start + Size <= (uintptr_t)Slab.base() + Slab.size();
+  };
+
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+  Pool &P = any_of(CodePool.Slabs, InSlab) ? CodePool : DataPool;
+  assert(any_of(P.Slabs, InSlab) && "Block was not allocated by this mapper");
+
+  // Merge the range with its free neighbours.
+  auto Next = P.Free.lower_bound(Start);
+  if (Next != P.Free.end() && Next->first == Start + Size) {
+    Size += Next->second;
+    Next = P.Free.erase(Next);
+  }
+  if (Next != P.Free.begin()) {
+    auto Prev = std::prev(Next);
+    if (Prev->first + Prev->second == Start) {
+      Prev->second += Size;
+      M = sys::MemoryBlock();
+      return std::error_code();
+    }
+  }
+  P.Free.insert(Next, std::make_pair(Start, Size));
+  M = sys::MemoryBlock();
+  return std::error_code();
+}
+
+size_t PooledMemoryMapper::getReservedSize() const {
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+  size_t Size = 0;
+  for (const Pool *P : {&CodePool, &DataPool})
+    for (const sys::MemoryBlock &Slab : P->Slabs)
+      Size += Slab.size();
+  return Size;
+}
+
+size_t PooledMemoryMapper::getFreeSize() const {
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+  size_t Size = 0;
+  for (const Pool *P : {&CodePool, &DataPool})
+    for (const auto &KV : P->Free)
+      Size += KV.second;
+  return Size;
+}
+
 } // namespace llvm
@@ -38,7 +38,10 @@ LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
     Int16Ty(C, 16),
     Int32Ty(C, 32),
     Int64Ty(C, 64),
-    Int128Ty(C, 128) {}
+    Int128Ty(C, 128) {
+  TypeAllocator.setMemoryCategory(MemoryCategory::IR);
+  MDStringCache.getAllocator().setMemoryCategory(MemoryCategory::Metadata);
+}
 
 LLVMContextImpl::~LLVMContextImpl() {
   // NOTE: We need to delete the contents of OwnedModules, but Module's dtor
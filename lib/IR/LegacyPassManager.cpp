@@ -27,6 +27,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -1619,6 +1620,13 @@ bool FPPassManager::runOnFunction(Function &F) {
   // Collect inherited analysis from Module level pass manager.
   populateInheritedAnalysis(TPM->activeStack);
 
+  TimeTraceScope FunctionScope("OptFunction", F.getName());
+
+  bool RecordStats = AreStatisticsDeltasEnabled();
+  StatisticsSnapshot StatsBefore;
+  if (RecordStats)
+    StatsBefore = GetStatisticsSnapshot();
+
   unsigned InstrCount, FunctionSize = 0;
   StringMap<std::pair<unsigned, unsigned>> FunctionToInstrCount;
   bool EmitICRemark = M.shouldEmitInstrCountChangedRemark();
@@ -1640,6 +1648,7 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      TimeTraceScope PassScope("RunPass", FP->getPassName());
       LocalChanged |= FP->runOnFunction(F);
       if (EmitICRemark) {
         unsigned NewSize = F.getInstructionCount();
@@ -1668,6 +1677,9 @@ bool FPPassManager::runOnFunction(Function &F) {
     recordAvailableAnalysis(FP);
     removeDeadPasses(FP, F.getName(), ON_FUNCTION_MSG);
   }
+
+  if (RecordStats)
+    RecordStatisticsDelta(M.getModuleIdentifier(), F.getName(), StatsBefore);
   return Changed;
 }
 
@@ -1706,6 +1718,8 @@ bool FPPassManager::doFinalization(Module &M) {
 /// the module, and if so, return true.
 bool
 MPPassManager::runOnModule(Module &M) {
+  TimeTraceScope TimeScope("OptModule", M.getName());
+
   bool Changed = false;
 
   // Initialize on-the-fly passes
@@ -1739,6 +1753,7 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      TimeTraceScope PassScope("RunPass", MP->getPassName());
 
       LocalChanged |= MP->runOnModule(M);
       if (EmitICRemark) {
@@ -1848,6 +1863,11 @@ bool PassManagerImpl::run(Module &M) {
   dumpArguments();
   dumpPasses();
 
+  bool RecordStats = AreStatisticsDeltasEnabled();
+  StatisticsSnapshot StatsBefore;
+  if (RecordStats)
+    StatsBefore = GetStatisticsSnapshot();
+
   for (ImmutablePass *ImPass : getImmutablePasses())
     Changed |= ImPass->doInitialization(M);
 
@@ -1860,6 +1880,8 @@ bool PassManagerImpl::run(Module &M) {
   for (ImmutablePass *ImPass : getImmutablePasses())
     Changed |= ImPass->doFinalization(M);
 
+  if (RecordStats)
+    RecordStatisticsDelta(M.getModuleIdentifier(), "", StatsBefore);
   return Changed;
 }
 
@@ -47,6 +47,7 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemoryAccounting.h"
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
@@ -482,7 +483,9 @@ void *MDNode::operator new(size_t Size, unsigned NumOps) {
   // uint64_t is the most aligned type we need support (ensured by static_assert
   // above)
   OpSize = alignTo(OpSize, alignof(uint64_t));
-  void *Ptr = reinterpret_cast<char *>(::operator new(OpSize + Size)) + OpSize;
+  void *Ptr = reinterpret_cast<char *>(allocateAccounted(
+                  OpSize + Size, MemoryCategory::Metadata)) +
+              OpSize;
   MDOperand *O = static_cast<MDOperand *>(Ptr);
   for (MDOperand *E = O - NumOps; O != E; --O)
     (void)new (O - 1) MDOperand;
@@ -497,7 +500,8 @@ void MDNode::operator delete(void *Mem) {
   MDOperand *O = static_cast<MDOperand *>(Mem);
   for (MDOperand *E = O - N->NumOperands; O != E; --O)
     (O - 1)->~MDOperand();
-  ::operator delete(reinterpret_cast<char *>(Mem) - OpSize);
+  deallocateAccounted(reinterpret_cast<char *>(Mem) - OpSize,
+                      MemoryCategory::Metadata);
 }
 
 MDNode::MDNode(LLVMContext &Context, unsigned ID, StorageType Storage,
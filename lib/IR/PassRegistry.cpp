@@ -15,9 +15,12 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/PassInfo.h"
 #include "llvm/PassSupport.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <memory>
+#include <mutex>
 #include <utility>
 
 using namespace llvm;
@@ -39,15 +42,23 @@ PassRegistry *PassRegistry::getPassRegistry() {
 PassRegistry::~PassRegistry() = default;
 
 const PassInfo *PassRegistry::getPassInfo(const void *TI) const {
-  sys::SmartScopedReader<true> Guard(Lock);
-  MapType::const_iterator I = PassInfoMap.find(TI);
-  return I != PassInfoMap.end() ? I->second : nullptr;
+  do {
+    sys::SmartScopedReader<true> Guard(Lock);
+    MapType::const_iterator I = PassInfoMap.find(TI);
+    if (I != PassInfoMap.end())
+      return I->second;
+  } while (runLazyInitializers());
+  return nullptr;
 }
 
 const PassInfo *PassRegistry::getPassInfo(StringRef Arg) const {
-  sys::SmartScopedReader<true> Guard(Lock);
-  StringMapType::const_iterator I = PassInfoStringMap.find(Arg);
-  return I != PassInfoStringMap.end() ? I->second : nullptr;
+  do {
+    sys::SmartScopedReader<true> Guard(Lock);
+    StringMapType::const_iterator I = PassInfoStringMap.find(Arg);
+    if (I != PassInfoStringMap.end())
+      return I->second;
+  } while (runLazyInitializers());
+  return nullptr;
 }
 
 //===----------------------------------------------------------------------===//
@@ -60,7 +71,20 @@ void PassRegistry::registerPass(const PassInfo &PI, bool ShouldFree) {
       PassInfoMap.insert(std::make_pair(PI.getTypeInfo(), &PI)).second;
   assert(Inserted && "Pass registered multiple times!");
   (void)Inserted;
-  PassInfoStringMap[PI.getPassArgument()] = &PI;
+
+  // Passes that can be named on the command line must have distinct names.
+  auto IsSelectable = [](const PassInfo &P) {
+    return !P.getPassArgument().empty() && P.getNormalCtor();
+  };
+  auto NameInsert = PassInfoStringMap.insert({PI.getPassArgument(), &PI});
+  if (!NameInsert.second) {
+    if (IsSelectable(PI) && IsSelectable(*NameInsert.first->second)) {
+      errs() << "Two passes with the same argument (-"
+             << PI.getPassArgument() << ") attempted to be registered!\n";
+      llvm_unreachable(nullptr);
+    }
+    NameInsert.first->second = &PI;
+  }
 
   // Notify any listeners.
   for (auto *Listener : Listeners)
@@ -70,7 +94,51 @@ void PassRegistry::registerPass(const PassInfo &PI, bool ShouldFree) {
     ToFree.push_back(std::unique_ptr<const PassInfo>(&PI));
 }
 
+void PassRegistry::registerLazyInitializer(
+    void (*Initializer)(PassRegistry &)) {
+  sys::SmartScopedWriter<true> Guard(Lock);
+  LazyInitializers.push_back(Initializer);
+  HasLazyInitializers = true;
+}
+
+bool PassRegistry::runLazyInitializers() const {
+  if (!HasLazyInitializers)
+    return false;
+
+  // The list is only looked at with LazyInitializersLock held, and the lock is
+  // held while the initializers run. A lookup that missed while another
+  // thread runs them waits for them and is then retried, rather than missing
+  // their passes. The initializers look passes up themselves; the lock is
+  // recursive, so those lookups find the list empty and return.
+  std::unique_lock<sys::SmartMutex<true>> InitGuard(LazyInitializersLock,
+                                                    std::try_to_lock);
+  if (!InitGuard.owns_lock()) {
+    InitGuard.lock();
+    return true;
+  }
+
+  std::vector<InitializerFn> Initializers;
+  {
+    sys::SmartScopedWriter<true> Guard(Lock);
+    if (LazyInitializers.empty())
+      return false;
+    std::swap(Initializers, LazyInitializers);
+  }
+
+  PassRegistry &Registry = const_cast<PassRegistry &>(*this);
+  for (InitializerFn Initializer : Initializers)
+    Initializer(Registry);
+
+  // Only clear the flag once the initializers are done: until then, a lookup
+  // on another thread may miss one of their passes and must wait for them.
+  sys::SmartScopedWriter<true> Guard(Lock);
+  if (LazyInitializers.empty())
+    HasLazyInitializers = false;
+  return true;
+}
+
 void PassRegistry::enumerateWith(PassRegistrationListener *L) {
+  runLazyInitializers();
   sys::SmartScopedReader<true> Guard(Lock);
   for (auto PassInfoPair : PassInfoMap)
     L->passEnumerate(PassInfoPair.second);
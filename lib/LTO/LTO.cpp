@@ -28,6 +28,7 @@
 #include "llvm/Linker/IRMover.h"
 #include "llvm/Object/IRObjectFile.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -36,6 +37,7 @@
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/VCSRevision.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -62,30 +64,15 @@ cl::opt<bool> EnableLTOInternalization(
     "enable-lto-internalization", cl::init(true), cl::Hidden,
     cl::desc("Enable global value internalization in LTO"));
 
-// Computes a unique hash for the Module considering the current list of
-// export/import and other global analysis results.
-// The hash is produced in \p Key.
-void llvm::computeLTOCacheKey(
-    SmallString<40> &Key, const Config &Conf, const ModuleSummaryIndex &Index,
-    StringRef ModuleID, const FunctionImporter::ImportMapTy &ImportList,
-    const FunctionImporter::ExportSetTy &ExportList,
-    const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
-    const GVSummaryMapTy &DefinedGlobals,
-    const std::set<GlobalValue::GUID> &CfiFunctionDefs,
-    const std::set<GlobalValue::GUID> &CfiFunctionDecls) {
-  // Compute the unique hash for this entry.
-  // This is based on the current compiler version, the module itself, the
-  // export list, the hash for every single module in the import list, the
-  // list of ResolvedODR for the module, and the list of preserved symbols.
-  SHA1 Hasher;
-
+// Adds the compiler revision and the parts of the LTO configuration that
+// affect code generation to \p Hasher.
+static void addConfigToHash(SHA1 &Hasher, const Config &Conf) {
   // Start with the compiler revision
   Hasher.update(LLVM_VERSION_STRING);
 #ifdef LLVM_REVISION
   Hasher.update(LLVM_REVISION);
 #endif
 
-  // Include the parts of the LTO configuration that affect code generation.
   auto AddString = [&](StringRef Str) {
     Hasher.update(Str);
     Hasher.update(ArrayRef<uint8_t>{0});
@@ -98,18 +85,6 @@ void llvm::computeLTOCacheKey(
     Data[3] = I >> 24;
     Hasher.update(ArrayRef<uint8_t>{Data, 4});
   };
-  auto AddUint64 = [&](uint64_t I) {
-    uint8_t Data[8];
-    Data[0] = I;
-    Data[1] = I >> 8;
-    Data[2] = I >> 16;
-    Data[3] = I >> 24;
-    Data[4] = I >> 32;
-    Data[5] = I >> 40;
-    Data[6] = I >> 48;
-    Data[7] = I >> 56;
-    Hasher.update(ArrayRef<uint8_t>{Data, 8});
-  };
   AddString(Conf.CPU);
   // FIXME: Hash more of Options. For now all clients initialize Options from
   // command-line flags (which is unsupported in production), but may set
@@ -139,6 +114,53 @@ void llvm::computeLTOCacheKey(
   AddString(Conf.OverrideTriple);
   AddString(Conf.DefaultTriple);
   AddString(Conf.DwoDir);
+}
+
+// Computes a unique hash for the Module considering the current list of
+// export/import and other global analysis results.
+// The hash is produced in \p Key.
+void llvm::computeLTOCacheKey(
+    SmallString<40> &Key, const Config &Conf, const ModuleSummaryIndex &Index,
+    StringRef ModuleID, const FunctionImporter::ImportMapTy &ImportList,
+    const FunctionImporter::ExportSetTy &ExportList,
+    const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
+    const GVSummaryMapTy &DefinedGlobals,
+    const std::set<GlobalValue::GUID> &CfiFunctionDefs,
+    const std::set<GlobalValue::GUID> &CfiFunctionDecls) {
+  // Compute the unique hash for this entry.
+  // This is based on the current compiler version, the module itself, the
+  // export list, the hash for every single module in the import list, the
+  // list of ResolvedODR for the module, and the list of preserved symbols.
+  SHA1 Hasher;
+
+  // Start with the compiler revision and the parts of the LTO configuration
+  // that affect code generation.
+  addConfigToHash(Hasher, Conf);
+
+  auto AddString = [&](StringRef Str) {
+    Hasher.update(Str);
+    Hasher.update(ArrayRef<uint8_t>{0});
+  };
+  auto AddUnsigned = [&](unsigned I) {
+    uint8_t Data[4];
+    Data[0] = I;
+    Data[1] = I >> 8;
+    Data[2] = I >> 16;
+    Data[3] = I >> 24;
+    Hasher.update(ArrayRef<uint8_t>{Data, 4});
+  };
+  auto AddUint64 = [&](uint64_t I) {
+    uint8_t Data[8];
+    Data[0] = I;
+    Data[1] = I >> 8;
+    Data[2] = I >> 16;
+    Data[3] = I >> 24;
+    Data[4] = I >> 32;
+    Data[5] = I >> 40;
+    Data[6] = I >> 48;
+    Data[7] = I >> 56;
+    Hasher.update(ArrayRef<uint8_t>{Data, 8});
+  };
 
   // Include the hash for the current module
   auto ModHash = Index.getModuleHash(ModuleID);
@@ -292,6 +314,19 @@ void llvm::computeLTOCacheKey(
   Key = toHex(Hasher.result());
 }
 
+// Computes a unique hash for a regular LTO codegen partition. The partition
+// has already been optimized, so its bitcode and the code generation options
+// fully determine the object file.
+void llvm::computeLTOCodeGenCacheKey(SmallString<40> &Key, const Config &Conf,
+                                     StringRef Bitcode) {
+  SHA1 Hasher;
+  addConfigToHash(Hasher, Conf);
+  // Keep these keys apart from the ThinLTO backend ones in a shared cache.
+  Hasher.update("codegen partition");
+  Hasher.update(Bitcode);
+  Key = toHex(Hasher.result());
+}
+
 static void thinLTOResolvePrevailingGUID(
     GlobalValueSummaryList &GVSummaryList, GlobalValue::GUID GUID,
     DenseSet<GlobalValueSummary *> &GlobalInvolvedWithAlias,
@@ -850,7 +885,7 @@ Error LTO::run(AddStreamFn AddStream, NativeObjectCache Cache) {
     StatsFile->keep();
   }
 
-  Error Result = runRegularLTO(AddStream);
+  Error Result = runRegularLTO(AddStream, Cache);
   if (!Result)
     Result = runThinLTO(AddStream, Cache);
 
@@ -860,7 +895,8 @@ Error LTO::run(AddStreamFn AddStream, NativeObjectCache Cache) {
   return Result;
 }
 
-Error LTO::runRegularLTO(AddStreamFn AddStream) {
+Error LTO::runRegularLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
+  TimeTraceScope TimeScope("RunRegularLTO", StringRef());
   for (auto &M : RegularLTO.ModsWithSummaries)
     if (Error Err = linkRegularLTO(std::move(M),
                                    /*LivenessFromIndex=*/true))
@@ -924,7 +960,8 @@ Error LTO::runRegularLTO(AddStreamFn AddStream) {
       return Error::success();
   }
   return backend(Conf, AddStream, RegularLTO.ParallelCodeGenParallelismLevel,
-                 std::move(RegularLTO.CombinedModule), ThinLTO.CombinedIndex);
+                 std::move(RegularLTO.CombinedModule), ThinLTO.CombinedIndex,
+                 Conf.CacheCodeGenPartitions ? Cache : nullptr);
 }
 
 /// This class defines the interface to the ThinLTO backend.
@@ -1164,6 +1201,8 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
   if (ThinLTO.ModuleMap.empty())
     return Error::success();
 
+  TimeTraceScope TimeScope("RunThinLTO", StringRef());
+
   if (Conf.CombinedIndexHook && !Conf.CombinedIndexHook(ThinLTO.CombinedIndex))
     return Error::success();
 
@@ -1198,7 +1237,8 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
 
   if (Conf.OptLevel > 0)
     ComputeCrossModuleImport(ThinLTO.CombinedIndex, ModuleToDefinedGVSummaries,
-                             ImportLists, ExportLists);
+                             ImportLists, ExportLists,
+                             Conf.ThinLTOImportCachePath);
 
   // Figure out which symbols need to be internalized. This also needs to happen
   // at -O0 because summary-based DCE is implemented using internalization, and
@@ -1262,6 +1302,31 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
   return BackendProc->wait();
 }
 
+namespace {
+// A native object stream that commits its mapped output file once the
+// backend is done with it.
+struct MappedObjectStream : NativeObjectStream {
+  MappedObjectStream(std::unique_ptr<raw_mapped_file_ostream> OS)
+      : NativeObjectStream(std::move(OS)) {}
+
+  ~MappedObjectStream() override {
+    auto &MappedOS = static_cast<raw_mapped_file_ostream &>(*OS);
+    if (Error E = MappedOS.commit())
+      report_fatal_error(Twine("Failed to write native object: ") +
+                         toString(std::move(E)));
+  }
+};
+} // end anonymous namespace
+
+Expected<std::unique_ptr<NativeObjectStream>>
+lto::createNativeObjectFileStream(StringRef Path) {
+  Expected<std::unique_ptr<raw_mapped_file_ostream>> OSOrErr =
+      raw_mapped_file_ostream::create(Path);
+  if (!OSOrErr)
+    return OSOrErr.takeError();
+  return llvm::make_unique<MappedObjectStream>(std::move(*OSOrErr));
+}
+
 Expected<std::unique_ptr<ToolOutputFile>>
 lto::setupOptimizationRemarks(LLVMContext &Context,
                               StringRef LTORemarksFilename,
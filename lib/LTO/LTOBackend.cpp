@@ -35,6 +35,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
@@ -300,6 +301,8 @@ void codegen(Config &Conf, TargetMachine *TM, AddStreamFn AddStream,
   if (Conf.PreCodeGenModuleHook && !Conf.PreCodeGenModuleHook(Task, Mod))
     return;
 
+  TimeTraceScope TimeScope("CodeGen", Mod.getModuleIdentifier());
+
   std::unique_ptr<ToolOutputFile> DwoOut;
   SmallString<1024> DwoFile(Conf.DwoPath);
   if (!Conf.DwoDir.empty()) {
@@ -334,7 +337,7 @@ void codegen(Config &Conf, TargetMachine *TM, AddStreamFn AddStream,
 
 void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
                   unsigned ParallelCodeGenParallelismLevel,
-                  std::unique_ptr<Module> Mod) {
+                  std::unique_ptr<Module> Mod, NativeObjectCache Cache) {
   ThreadPool CodegenThreadPool(ParallelCodeGenParallelismLevel);
   unsigned ThreadCount = 0;
   const Target *T = &TM->getTarget();
@@ -352,9 +355,26 @@ void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
         raw_svector_ostream BCOS(BC);
         WriteBitcodeToFile(*MPart, BCOS);
 
+        // The partition is already optimized, so its bitcode is all the cache
+        // key needs besides the codegen options. Split DWARF output is not
+        // cached, so don't cache the objects that refer to it either.
+        SmallString<40> Key;
+        if (Cache && C.DwoDir.empty() && C.DwoPath.empty())
+          computeLTOCodeGenCacheKey(Key, C, BC);
+
         // Enqueue the task
         CodegenThreadPool.async(
-            [&](const SmallString<0> &BC, unsigned ThreadId) {
+            [&](const SmallString<0> &BC, const SmallString<40> &Key,
+                unsigned ThreadId) {
+              AddStreamFn PartAddStream = AddStream;
+              if (!Key.empty()) {
+                // A null stream function means that the object was found in
+                // the cache and has already been passed to the linker.
+                PartAddStream = Cache(ThreadId, Key);
+                if (!PartAddStream)
+                  return;
+              }
+
               LTOLLVMContext Ctx(C);
               Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
                   MemoryBufferRef(StringRef(BC.data(), BC.size()), "ld-temp.o"),
@@ -366,13 +386,13 @@ void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
               std::unique_ptr<TargetMachine> TM =
                   createTargetMachine(C, T, *MPartInCtx);
 
-              codegen(C, TM.get(), AddStream, ThreadId, *MPartInCtx);
+              codegen(C, TM.get(), PartAddStream, ThreadId, *MPartInCtx);
             },
             // Pass BC using std::move to ensure that it get moved rather than
             // copied into the thread's context.
-            std::move(BC), ThreadCount++);
+            std::move(BC), std::move(Key), ThreadCount++);
       },
-      false);
+      false, C.BalanceCodeGenPartitions);
 
   // Because the inner lambda (which runs in a worker thread) captures our local
   // variables, we need to wait for the worker threads to terminate before we
@@ -409,7 +429,9 @@ finalizeOptimizationRemarks(std::unique_ptr<ToolOutputFile> DiagOutputFile) {
 Error lto::backend(Config &C, AddStreamFn AddStream,
                    unsigned ParallelCodeGenParallelismLevel,
                    std::unique_ptr<Module> Mod,
-                   ModuleSummaryIndex &CombinedIndex) {
+                   ModuleSummaryIndex &CombinedIndex, NativeObjectCache Cache) {
+  TimeTraceScope TimeScope("LTOBackend", Mod->getModuleIdentifier());
+
   Expected<const Target *> TOrErr = initAndLookupTarget(C, *Mod);
   if (!TOrErr)
     return TOrErr.takeError();
@@ -433,7 +455,7 @@ Error lto::backend(Config &C, AddStreamFn AddStream,
     codegen(C, TM.get(), AddStream, 0, *Mod);
   } else {
     splitCodeGen(C, TM.get(), AddStream, ParallelCodeGenParallelismLevel,
-                 std::move(Mod));
+                 std::move(Mod), std::move(Cache));
   }
   return finalizeOptimizationRemarks(std::move(DiagnosticOutputFile));
 }
@@ -464,6 +486,8 @@ Error lto::thinBackend(Config &Conf, unsigned Task, AddStreamFn AddStream,
                        const FunctionImporter::ImportMapTy &ImportList,
                        const GVSummaryMapTy &DefinedGlobals,
                        MapVector<StringRef, BitcodeModule> &ModuleMap) {
+  TimeTraceScope TimeScope("ThinLTOBackend", Mod.getModuleIdentifier());
+
   Expected<const Target *> TOrErr = initAndLookupTarget(Conf, Mod);
   if (!TOrErr)
     return TOrErr.takeError();
@@ -838,6 +838,26 @@ bool ELFWriter::maybeWriteCompression(
   return true;
 }
 
+namespace {
+/// Feeds everything written to it into a zlib::BlockCompressor, so that a
+/// section can be compressed without first being written out in full.
+class raw_compressing_ostream : public raw_ostream {
+  zlib::BlockCompressor &Compressor;
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Compressor.write(StringRef(Ptr, Size));
+  }
+  uint64_t current_pos() const override { return Compressor.getInputSize(); }
+
+public:
+  explicit raw_compressing_ostream(zlib::BlockCompressor &Compressor)
+      : Compressor(Compressor) {
+    SetBufferSize(64 * 1024);
+  }
+  ~raw_compressing_ostream() override { flush(); }
+};
+} // end anonymous namespace
+
 void ELFWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
                                  const MCAsmLayout &Layout) {
   MCSectionELF &Section = static_cast<MCSectionELF &>(Sec);
@@ -861,23 +881,28 @@ void ELFWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
           MAI->compressDebugSections() == DebugCompressionType::GNU) &&
          "expected zlib or zlib-gnu style compression");
 
-  SmallVector<char, 128> UncompressedData;
-  raw_svector_ostream VecOS(UncompressedData);
-  Asm.writeSectionData(VecOS, &Section, Layout);
-
+  // Compress the section as it is written, in blocks on several threads. Only
+  // the compressed contents are held in full; if compression does not pay
+  // off, the section is written out a second time.
   SmallVector<char, 128> CompressedContents;
-  if (Error E = zlib::compress(
-          StringRef(UncompressedData.data(), UncompressedData.size()),
-          CompressedContents)) {
+  zlib::BlockCompressor Compressor([&](StringRef Data) {
+    CompressedContents.append(Data.begin(), Data.end());
+  });
+  {
+    raw_compressing_ostream CompressOS(Compressor);
+    Asm.writeSectionData(CompressOS, &Section, Layout);
+  }
+  uint64_t UncompressedSize = Compressor.getInputSize();
+  if (Error E = Compressor.finish()) {
     consumeError(std::move(E));
-    W.OS << UncompressedData;
+    Asm.writeSectionData(W.OS, &Section, Layout);
     return;
   }
 
   bool ZlibStyle = MAI->compressDebugSections() == DebugCompressionType::Z;
-  if (!maybeWriteCompression(UncompressedData.size(), CompressedContents,
-                             ZlibStyle, Sec.getAlignment())) {
-    W.OS << UncompressedData;
+  if (!maybeWriteCompression(UncompressedSize, CompressedContents, ZlibStyle,
+                             Sec.getAlignment())) {
+    Asm.writeSectionData(W.OS, &Section, Layout);
     return;
   }
 
@@ -1073,6 +1098,13 @@ uint64_t ELFWriter::writeObject(MCAssembler &Asm, const MCAsmLayout &Layout) {
 
   std::map<const MCSymbol *, std::vector<const MCSectionELF *>> GroupMembers;
 
+  // The section contents make up most of the object, so let the stream make
+  // room for them once instead of growing as they are written.
+  uint64_t ContentSize = 0;
+  for (const MCSection &Sec : Asm)
+    ContentSize += Layout.getSectionFileSize(&Sec);
+  W.OS.reserveExtraSpace(ContentSize);
+
   // Write out the ELF header ...
   writeHeader(Asm);
 
@@ -61,6 +61,7 @@ MCContext::MCContext(const MCAsmInfo *mai, const MCRegisterInfo *mri,
       CurrentDwarfLoc(0, 0, 0, DWARF2_FLAG_IS_STMT, 0, 0),
       AutoReset(DoAutoReset) {
   SecureLogFile = AsSecureLogFileName;
+  Allocator.setMemoryCategory(MemoryCategory::MC);
 
   if (SrcMgr && SrcMgr->getNumBuffers())
     MainFileName =
@@ -125,9 +126,12 @@ MCSymbol *MCContext::getOrCreateSymbol(const Twine &Name) {
 
   assert(!NameRef.empty() && "Normal symbols cannot be unnamed!");
 
-  MCSymbol *&Sym = Symbols[NameRef];
+  // Symbols, UsedNames and NextID all hash the same name.
+  unsigned NameHash = StringMapImpl::hash(NameRef);
+  MCSymbol *&Sym =
+      Symbols.try_emplace_with_hash(NameRef, NameHash).first->second;
   if (!Sym)
-    Sym = createSymbol(NameRef, false, false);
+    Sym = createNamedSymbol(NameRef, NameHash, false, false);
 
   return Sym;
 }
@@ -170,7 +174,13 @@ MCSymbol *MCContext::createSymbol(StringRef Name, bool AlwaysAddSuffix,
                                   bool CanBeUnnamed) {
   if (CanBeUnnamed && !UseNamesOnTempLabels)
     return createSymbolImpl(nullptr, true);
+  return createNamedSymbol(Name, StringMapImpl::hash(Name), AlwaysAddSuffix,
+                           CanBeUnnamed);
+}
 
+MCSymbol *MCContext::createNamedSymbol(StringRef Name, unsigned NameHash,
+                                       bool AlwaysAddSuffix,
+                                       bool CanBeUnnamed) {
   // Determine whether this is a user written assembler temporary or normal
   // label, if used.
   bool IsTemporary = CanBeUnnamed;
@@ -179,13 +189,19 @@ MCSymbol *MCContext::createSymbol(StringRef Name, bool AlwaysAddSuffix,
 
   SmallString<128> NewName = Name;
   bool AddSuffix = AlwaysAddSuffix;
-  unsigned &NextUniqueID = NextID[Name];
+  unsigned *NextUniqueID = nullptr;
   while (true) {
+    std::pair<StringMap<bool, BumpPtrAllocator &>::iterator, bool> NameEntry;
     if (AddSuffix) {
+      if (!NextUniqueID)
+        NextUniqueID =
+            &NextID.try_emplace_with_hash(Name, NameHash).first->second;
       NewName.resize(Name.size());
-      raw_svector_ostream(NewName) << NextUniqueID++;
+      raw_svector_ostream(NewName) << (*NextUniqueID)++;
+      NameEntry = UsedNames.try_emplace(NewName, true);
+    } else {
+      NameEntry = UsedNames.try_emplace_with_hash(Name, NameHash, true);
     }
-    auto NameEntry = UsedNames.insert(std::make_pair(NewName, true));
     if (NameEntry.second || !NameEntry.first->second) {
       // Ok, we found a name.
       // Mark it as used for a non-section symbol.
@@ -11,7 +11,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Allocator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Memory.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace llvm {
 
@@ -26,6 +32,266 @@ void printBumpPtrAllocatorStats(unsigned NumSlabs, size_t BytesAllocated,
          << " (includes alignment, etc)\n";
 }
 
+namespace {
+
+/// A slab in a free list of the pool.
+struct FreeSlab {
+  FreeSlab *Next;
+};
+
+const size_t MinPooledSlabSize = 4096;
+const unsigned NumSizeClasses = 5;
+const unsigned NumShards = 8;
+/// The size of the chunks the pool gets from the system, which is the size of
+/// a huge page on x86 and AArch64 Linux.
+const size_t ChunkSize = 2 * 1024 * 1024;
+/// How much more free memory the pool may hold than after the last time it
+/// released its unused chunks before it tries again.
+const size_t ReleaseThreshold = 8 * ChunkSize;
+
+/// The free slabs of one shard of the pool, by size.
+struct PoolShard {
+  std::mutex Mutex;
+  FreeSlab *FreeLists[NumSizeClasses] = {};
+  // Keep the shards of different threads off each other's cache lines.
+  char Padding[64];
+
+  void *pop(unsigned SizeClass) {
+    FreeSlab *Slab = FreeLists[SizeClass];
+    if (Slab)
+      FreeLists[SizeClass] = Slab->Next;
+    return Slab;
+  }
+
+  void push(void *Ptr, unsigned SizeClass) {
+    FreeSlab *Slab = static_cast<FreeSlab *>(Ptr);
+    Slab->Next = FreeLists[SizeClass];
+    FreeLists[SizeClass] = Slab;
+  }
+};
+
+class SlabPool {
+public:
+  void *allocate(size_t Size);
+  void deallocate(void *Slab, size_t Size);
+  size_t releaseFreeChunks();
+
+private:
+  PoolShard &getThreadShard();
+  void *carve(size_t Size, PoolShard &Shard);
+  size_t releaseFreeChunksLocked();
+
+  PoolShard Shards[NumShards];
+  std::atomic<unsigned> NextShard{0};
+
+  /// The bytes in the free lists, and the amount at which deallocate next
+  /// releases unused chunks.
+  std::atomic<size_t> FreeBytes{0};
+  std::atomic<size_t> NextReleaseAt{ReleaseThreshold};
+
+  /// The unused part of the current chunk, and every chunk mapped, guarded
+  /// by ChunkMutex. It is taken before any shard lock.
+  std::mutex ChunkMutex;
+  char *ChunkPtr = nullptr;
+  char *ChunkEnd = nullptr;
+  std::vector<sys::MemoryBlock> Chunks;
+};
+
+} // end anonymous namespace
+
+// The shard of the current thread plus one, or 0 if it has none yet.
+static LLVM_THREAD_LOCAL unsigned ThreadShard;
+
+static unsigned getSizeClass(size_t Size) {
+  return Log2_64(Size) - Log2_64(MinPooledSlabSize);
+}
+
+PoolShard &SlabPool::getThreadShard() {
+  if (!ThreadShard)
+    ThreadShard = NextShard++ % NumShards + 1;
+  return Shards[ThreadShard - 1];
+}
+
+void *SlabPool::allocate(size_t Size) {
+  unsigned SizeClass = getSizeClass(Size);
+  PoolShard &Own = getThreadShard();
+  {
+    std::lock_guard<std::mutex> Lock(Own.Mutex);
+    if (void *Slab = Own.pop(SizeClass)) {
+      FreeBytes -= Size;
+      return Slab;
+    }
+  }
+  // Before growing the pool, take a slab that another thread freed, e.g. when
+  // one thread creates the allocators and another destroys them.
+  for (PoolShard &Other : Shards) {
+    if (&Other == &Own)
+      continue;
+    std::unique_lock<std::mutex> Lock(Other.Mutex, std::try_to_lock);
+    if (!Lock.owns_lock())
+      continue;
+    if (void *Slab = Other.pop(SizeClass)) {
+      FreeBytes -= Size;
+      return Slab;
+    }
+  }
+  return carve(Size, Own);
+}
+
+void SlabPool::deallocate(void *Slab, size_t Size) {
+  PoolShard &Own = getThreadShard();
+  size_t Free;
+  {
+    // FreeBytes only changes with a shard lock held, so that it matches the
+    // free lists while releaseFreeChunks holds all of them.
+    std::lock_guard<std::mutex> Lock(Own.Mutex);
+    Own.push(Slab, getSizeClass(Size));
+    Free = FreeBytes += Size;
+  }
+  // Give memory back once a lot of it sits unused, e.g. after a JIT or an
+  // LTO backend is done with a large module. A thread that finds another one
+  // releasing leaves it to that one.
+  if (Free < NextReleaseAt)
+    return;
+  std::unique_lock<std::mutex> ChunkLock(ChunkMutex, std::try_to_lock);
+  if (ChunkLock.owns_lock())
+    releaseFreeChunksLocked();
+}
+
+void *SlabPool::carve(size_t Size, PoolShard &Shard) {
+  std::lock_guard<std::mutex> ChunkLock(ChunkMutex);
+  // Slabs are aligned to their size within the chunk. Chunks are a multiple
+  // of every pooled size, so the parts skipped over by aligning, as well as
+  // the rest of a chunk that is too small, can be split into the smallest
+  // slabs and put in the free list.
+  auto Release = [&](char *Begin, char *End) {
+    if (Begin == End)
+      return;
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    FreeBytes += End - Begin;
+    for (; Begin != End; Begin += MinPooledSlabSize)
+      Shard.push(Begin, 0);
+  };
+  char *Slab = reinterpret_cast<char *>(alignAddr(ChunkPtr, Size));
+  if (!ChunkPtr || Slab + Size > ChunkEnd) {
+    Release(ChunkPtr, ChunkEnd);
+    // Most processes never need more than the first chunk, and with a normal
+    // mapping only the pages they touch take up memory. Ask for huge pages
+    // once the pool grows beyond it.
+    unsigned Flags = sys::Memory::MF_READ | sys::Memory::MF_WRITE;
+    if (!Chunks.empty())
+      Flags |= sys::Memory::MF_HUGE_PAGE;
+    std::error_code EC;
+    sys::MemoryBlock Chunk =
+        sys::Memory::allocateMappedMemory(ChunkSize, nullptr, Flags, EC);
+    if (EC)
+      report_bad_alloc_error("Unable to allocate memory for the slab pool");
+    ChunkPtr = static_cast<char *>(Chunk.base());
+    ChunkEnd = ChunkPtr + Chunk.size();
+    Chunks.push_back(Chunk);
+    Slab = reinterpret_cast<char *>(alignAddr(ChunkPtr, Size));
+  }
+  Release(ChunkPtr, Slab);
+  ChunkPtr = Slab + Size;
+  return Slab;
+}
+
+size_t SlabPool::releaseFreeChunks() {
+  std::lock_guard<std::mutex> ChunkLock(ChunkMutex);
+  return releaseFreeChunksLocked();
+}
+
+size_t SlabPool::releaseFreeChunksLocked() {
+  std::unique_lock<std::mutex> ShardLocks[NumShards];
+  for (unsigned I = 0; I != NumShards; ++I)
+    ShardLocks[I] = std::unique_lock<std::mutex>(Shards[I].Mutex);
+
+  // Count the free bytes in each chunk: its slabs in the free lists, and the
+  // part of the current chunk that was not carved yet.
+  llvm::sort(Chunks, [](const sys::MemoryBlock &A, const sys::MemoryBlock &B) {
+    return A.base() < B.base();
+  });
+  auto FindChunk = [&](const void *Ptr) {
+    auto I = std::upper_bound(Chunks.begin(), Chunks.end(), Ptr,
+                              [](const void *P, const sys::MemoryBlock &C) {
+                                return P < C.base();
+                              });
+    assert(I != Chunks.begin() && "Slab outside of the pool's chunks");
+    return I - Chunks.begin() - 1;
+  };
+  std::vector<size_t> ChunkFreeBytes(Chunks.size());
+  for (PoolShard &Shard : Shards)
+    for (unsigned SizeClass = 0; SizeClass != NumSizeClasses; ++SizeClass)
+      for (FreeSlab *Slab = Shard.FreeLists[SizeClass]; Slab;
+           Slab = Slab->Next)
+        ChunkFreeBytes[FindChunk(Slab)] += MinPooledSlabSize << SizeClass;
+  if (ChunkPtr != ChunkEnd)
+    ChunkFreeBytes[FindChunk(ChunkPtr)] += ChunkEnd - ChunkPtr;
+
+  std::vector<bool> Unused(Chunks.size());
+  bool AnyUnused = false;
+  size_t FreeInUnused = 0;
+  for (size_t I = 0, E = Chunks.size(); I != E; ++I) {
+    Unused[I] = ChunkFreeBytes[I] == Chunks[I].size();
+    AnyUnused |= Unused[I];
+    if (Unused[I])
+      FreeInUnused += ChunkFreeBytes[I];
+  }
+  // The part of the current chunk not carved yet is not in the free lists.
+  bool CurrentUnused = ChunkPtr != ChunkEnd && Unused[FindChunk(ChunkPtr)];
+  if (CurrentUnused)
+    FreeInUnused -= ChunkEnd - ChunkPtr;
+  FreeBytes -= FreeInUnused;
+  NextReleaseAt = FreeBytes + ReleaseThreshold;
+  if (!AnyUnused)
+    return 0;
+
+  // Unlink the slabs of the unused chunks, then unmap those.
+  for (PoolShard &Shard : Shards) {
+    for (unsigned SizeClass = 0; SizeClass != NumSizeClasses; ++SizeClass) {
+      FreeSlab **Link = &Shard.FreeLists[SizeClass];
+      while (FreeSlab *Slab = *Link) {
+        if (Unused[FindChunk(Slab)])
+          *Link = Slab->Next;
+        else
+          Link = &Slab->Next;
+      }
+    }
+  }
+  if (CurrentUnused)
+    ChunkPtr = ChunkEnd = nullptr;
+
+  size_t Released = 0;
+  std::vector<sys::MemoryBlock> Kept;
+  for (size_t I = 0, E = Chunks.size(); I != E; ++I) {
+    if (!Unused[I]) {
+      Kept.push_back(Chunks[I]);
+      continue;
+    }
+    Released += Chunks[I].size();
+    sys::Memory::releaseMappedMemory(Chunks[I]);
+  }
+  Chunks = std::move(Kept);
+  return Released;
+}
+
+static SlabPool &getSlabPool() {
+  // The pool is never destroyed, as allocators with static storage duration
+  // return their slabs during exit.
+  static SlabPool *Pool = new SlabPool();
+  return *Pool;
+}
+
+void *allocatePooledSlab(size_t Size) {
+  return getSlabPool().allocate(Size);
+}
+
+void deallocatePooledSlab(void *Slab, size_t Size) {
+  getSlabPool().deallocate(Slab, Size);
+}
+
+size_t releasePooledSlabs() { return getSlabPool().releaseFreeChunks(); }
+
 } // End namespace detail.
 
 void PrintRecyclerStats(size_t Size,
@@ -114,6 +114,36 @@ public:
   bool ParseCommandLineOptions(int argc, const char *const *argv,
                                StringRef Overview, raw_ostream *Errs = nullptr);
 
+  // Tools have thousands of options, most of them constructed before main()
+  // runs. Registering them only queues them; they are added to the option
+  // maps of their subcommands in one batch when the maps are first needed,
+  // which is usually when the command line is parsed.
+  void queueOption(Option *O) { PendingOptions.push_back({O, StringRef()}); }
+
+  void queueLiteralOption(Option &Opt, StringRef Name) {
+    PendingOptions.push_back({&Opt, Name});
+  }
+
+  /// Add the queued options to the option maps.
+  void addPendingOptions() {
+    if (LLVM_LIKELY(PendingOptions.empty()))
+      return;
+    std::vector<PendingOption> Pending;
+    std::swap(Pending, PendingOptions);
+
+    // Size the map of the top level up front rather than growing it one
+    // rehash at a time.
+    if (TopLevelSubCommand->OptionsMap.empty())
+      TopLevelSubCommand->OptionsMap = StringMap<Option *>(Pending.size());
+
+    for (const PendingOption &P : Pending) {
+      if (P.LiteralName.data())
+        addLiteralOption(*P.O, P.LiteralName);
+      else
+        addOption(P.O);
+    }
+  }
+
   void addLiteralOption(Option &Opt, SubCommand *SC, StringRef Name) {
     if (Opt.hasArgStr())
       return;
@@ -224,6 +254,7 @@ public:
   }
 
   void removeOption(Option *O) {
+    addPendingOptions();
     if (O->Subs.empty())
       removeOption(O, &*TopLevelSubCommand);
     else {
@@ -242,7 +273,8 @@ public:
             nullptr != Sub.ConsumeAfterOpt);
   }
 
-  bool hasOptions() const {
+  bool hasOptions() {
+    addPendingOptions();
     for (const auto &S : RegisteredSubCommands) {
       if (hasOptions(*S))
         return true;
@@ -263,6 +295,7 @@ public:
   }
 
   void updateArgStr(Option *O, StringRef NewName) {
+    addPendingOptions();
     if (O->Subs.empty())
       updateArgStr(O, NewName, &*TopLevelSubCommand);
     else {
@@ -323,6 +356,7 @@ public:
 
     MoreHelp.clear();
     RegisteredOptionCategories.clear();
+    PendingOptions.clear();
 
     ResetAllOptionOccurrences();
     RegisteredSubCommands.clear();
@@ -336,6 +370,13 @@ public:
 private:
   SubCommand *ActiveSubCommand;
 
+  struct PendingOption {
+    Option *O;
+    /// The name of a literal option, or null for a named option.
+    StringRef LiteralName;
+  };
+  std::vector<PendingOption> PendingOptions;
+
   Option *LookupOption(SubCommand &Sub, StringRef &Arg, StringRef &Value);
   SubCommand *LookupSubCommand(StringRef Name);
 };
@@ -345,7 +386,7 @@ private:
 static ManagedStatic<CommandLineParser> GlobalParser;
 
 void cl::AddLiteralOption(Option &O, StringRef Name) {
-  GlobalParser->addLiteralOption(O, Name);
+  GlobalParser->queueLiteralOption(O, Name);
 }
 
 extrahelp::extrahelp(StringRef Help) : morehelp(Help) {
@@ -353,7 +394,7 @@ extrahelp::extrahelp(StringRef Help) : morehelp(Help) {
 }
 
 void Option::addArgument() {
-  GlobalParser->addOption(this);
+  GlobalParser->queueOption(this);
   FullyInitialized = true;
 }
 
@@ -413,6 +454,10 @@ Option *CommandLineParser::LookupOption(SubCommand &Sub, StringRef &Arg,
     return nullptr;
   assert(&Sub != &*AllSubCommands);
 
+  // Options registered by the handlers of earlier arguments, e.g. by a plugin
+  // that -load brought in, must be visible to the rest of the command line.
+  addPendingOptions();
+
   size_t EqualPos = Arg.find('=');
 
   // If we have an equals sign, remember the value.
@@ -1096,6 +1141,7 @@ bool cl::ParseCommandLineOptions(int argc, const char *const *argv,
 void CommandLineParser::ResetAllOptionOccurrences() {
   // So that we can parse different command lines multiple times in succession
   // we reset all option values to look like they have never been seen before.
+  addPendingOptions();
   for (auto SC : RegisteredSubCommands) {
     for (auto &O : SC->OptionsMap)
       O.second->reset();
@@ -1106,6 +1152,7 @@ bool CommandLineParser::ParseCommandLineOptions(int argc,
                                                 const char *const *argv,
                                                 StringRef Overview,
                                                 raw_ostream *Errs) {
+  addPendingOptions();
   assert(hasOptions() && "No options specified!");
 
   // Expand response files.
@@ -1916,6 +1963,7 @@ public:
   }
 
   void printHelp() {
+    GlobalParser->addPendingOptions();
     SubCommand *Sub = GlobalParser->getActiveSubCommand();
     auto &OptionsMap = Sub->OptionsMap;
     auto &PositionalOpts = Sub->PositionalOpts;
@@ -2170,6 +2218,7 @@ void CommandLineParser::printOptionValues() {
   if (!PrintOptions && !PrintAllOptions)
     return;
 
+  addPendingOptions();
   SmallVector<std::pair<const char *, Option *>, 128> Opts;
   sortOpts(ActiveSubCommand->OptionsMap, Opts, /*ShowHidden*/ true);
 
@@ -2278,6 +2327,7 @@ StringMap<Option *> &cl::getRegisteredOptions(SubCommand &Sub) {
   auto &Subs = GlobalParser->RegisteredSubCommands;
   (void)Subs;
   assert(is_contained(Subs, &Sub));
+  GlobalParser->addPendingOptions();
   return Sub.OptionsMap;
 }
 
@@ -2287,6 +2337,7 @@ cl::getRegisteredSubcommands() {
 }
 
 void cl::HideUnrelatedOptions(cl::OptionCategory &Category, SubCommand &Sub) {
+  GlobalParser->addPendingOptions();
   for (auto &I : Sub.OptionsMap) {
     if (I.second->Category != &Category &&
         I.second->Category != &GenericCategory)
@@ -2296,6 +2347,7 @@ void cl::HideUnrelatedOptions(cl::OptionCategory &Category, SubCommand &Sub) {
 
 void cl::HideUnrelatedOptions(ArrayRef<const cl::OptionCategory *> Categories,
                               SubCommand &Sub) {
+  GlobalParser->addPendingOptions();
   auto CategoriesBegin = Categories.begin();
   auto CategoriesEnd = Categories.end();
   for (auto &I : Sub.OptionsMap) {
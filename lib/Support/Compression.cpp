@@ -17,6 +17,9 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Threading.h"
+#include <algorithm>
 #if LLVM_ENABLE_ZLIB == 1 && HAVE_ZLIB_H
 #include <zlib.h>
 #endif
@@ -85,6 +88,158 @@ uint32_t zlib::crc32(StringRef Buffer) {
   return ::crc32(0, (const Bytef *)Buffer.data(), Buffer.size());
 }
 
+// Back-references in deflate reach at most this far.
+static const size_t DeflateWindow = 32 * 1024;
+
+zlib::BlockCompressor::BlockCompressor(SinkFn Sink, int Level,
+                                       size_t BlockSize)
+    : Sink(std::move(Sink)), Level(Level), BlockSize(BlockSize),
+      Adler(::adler32(0, nullptr, 0)) {
+  // A few blocks per thread, so that threads finishing early find work.
+  WindowSize = BlockSize * 4 * std::max(1u, hardware_concurrency());
+}
+
+namespace {
+struct CompressedBlock {
+  SmallVector<char, 0> Data;
+  uint32_t Adler;
+  int Status;
+};
+} // end anonymous namespace
+
+// Deflate Block as raw deflate data, as if the stream so far had been Dict.
+// Unless Final, end on a byte boundary with an empty stored block, so that the
+// next block can be appended.
+static CompressedBlock deflateBlock(StringRef Block, StringRef Dict,
+                                    int Level, bool Final) {
+  CompressedBlock Result;
+  Result.Adler =
+      ::adler32(::adler32(0, nullptr, 0), (const Bytef *)Block.data(),
+                Block.size());
+  z_stream S = {};
+  Result.Status = deflateInit2(&S, Level, Z_DEFLATED, -MAX_WBITS, 8,
+                               Z_DEFAULT_STRATEGY);
+  if (Result.Status != Z_OK)
+    return Result;
+  if (!Dict.empty())
+    Result.Status = deflateSetDictionary(&S, (const Bytef *)Dict.data(),
+                                         Dict.size());
+  if (Result.Status == Z_OK) {
+    // deflateBound does not cover the marker of a sync flush.
+    Result.Data.resize(deflateBound(&S, Block.size()) + 16);
+    S.next_in = (Bytef *)Block.data();
+    S.avail_in = Block.size();
+    S.next_out = (Bytef *)Result.Data.data();
+    S.avail_out = Result.Data.size();
+    int Res = deflate(&S, Final ? Z_FINISH : Z_SYNC_FLUSH);
+    if (Res == (Final ? Z_STREAM_END : Z_OK) && S.avail_in == 0) {
+      __msan_unpoison(Result.Data.data(), S.total_out);
+      Result.Data.resize(S.total_out);
+      Result.Status = Z_OK;
+    } else {
+      Result.Status = Res == Z_OK || Res == Z_STREAM_END ? Z_BUF_ERROR : Res;
+    }
+  }
+  deflateEnd(&S);
+  return Result;
+}
+
+void zlib::BlockCompressor::compressWindow(StringRef Data, bool Final) {
+  size_t NumBlocks = std::max<size_t>(1, (Data.size() + BlockSize - 1) /
+                                             BlockSize);
+  std::vector<CompressedBlock> Blocks(NumBlocks);
+  auto CompressBlock = [&](size_t I) {
+    size_t Begin = I * BlockSize;
+    StringRef Block = Data.substr(Begin, BlockSize);
+    StringRef Dict = I == 0 ? StringRef(Dictionary)
+                            : Data.slice(Begin - std::min(Begin, DeflateWindow),
+                                         Begin);
+    Blocks[I] = deflateBlock(Block, Dict, Level, Final && I == NumBlocks - 1);
+  };
+  if (NumBlocks == 1)
+    CompressBlock(0);
+  else
+    parallel::for_each_n(parallel::par, size_t(0), NumBlocks, CompressBlock);
+
+  if (!WroteHeader) {
+    // CMF: deflate with a 32 KiB window. FLG: the compression level, and a
+    // check value that makes the header a multiple of 31.
+    unsigned FLevel = Level < 0 ? 2 : Level < 2 ? 0 : Level < 6 ? 1
+                      : Level == 6 ? 2 : 3;
+    unsigned Header = 0x7800 | (FLevel << 6);
+    Header += 31 - Header % 31;
+    char Bytes[] = {char(Header >> 8), char(Header & 0xff)};
+    Sink(StringRef(Bytes, 2));
+    WroteHeader = true;
+  }
+
+  for (size_t I = 0; I != NumBlocks; ++I) {
+    CompressedBlock &B = Blocks[I];
+    if (B.Status != Z_OK) {
+      if (!Status)
+        Status = B.Status;
+      return;
+    }
+    size_t Length = std::min(BlockSize, Data.size() - I * BlockSize);
+    Adler = ::adler32_combine(Adler, B.Adler, Length);
+    Sink(StringRef(B.Data.data(), B.Data.size()));
+    // Release the output before compressing the next window.
+    B.Data = SmallVector<char, 0>();
+  }
+
+  if (!Final) {
+    Dictionary = Data.take_back(DeflateWindow);
+    return;
+  }
+  char Trailer[] = {char(Adler >> 24), char(Adler >> 16), char(Adler >> 8),
+                    char(Adler)};
+  Sink(StringRef(Trailer, 4));
+}
+
+void zlib::BlockCompressor::write(StringRef Data) {
+  InputSize += Data.size();
+  if (Status)
+    return;
+  // A window is compressed only once more input follows it, so that the last
+  // block of the stream is always the one finish() marks final.
+  if (!Pending.empty()) {
+    size_t Take = std::min(Data.size(), WindowSize - Pending.size());
+    Pending.append(Data.data(), Take);
+    Data = Data.drop_front(Take);
+    if (Data.empty())
+      return;
+    compressWindow(Pending, /*Final=*/false);
+    Pending.clear();
+  }
+  // Compress whole windows straight out of the caller's buffer.
+  while (Data.size() > WindowSize && !Status) {
+    compressWindow(Data.take_front(WindowSize), /*Final=*/false);
+    Data = Data.drop_front(WindowSize);
+  }
+  Pending.assign(Data.data(), Data.size());
+}
+
+Error zlib::BlockCompressor::finish() {
+  if (!Status)
+    compressWindow(Pending, /*Final=*/true);
+  Pending = std::string();
+  Dictionary = std::string();
+  return Status ? createError(convertZlibCodeToString(Status))
+                : Error::success();
+}
+
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level) {
+  BlockCompressor Compressor(
+      [&](StringRef Data) {
+        CompressedBuffer.append(Data.begin(), Data.end());
+      },
+      Level);
+  Compressor.write(InputBuffer);
+  return Compressor.finish();
+}
+
 #else
 bool zlib::isAvailable() { return false; }
 Error zlib::compress(StringRef InputBuffer,
@@ -103,4 +258,19 @@ Error zlib::uncompress(StringRef InputBuffer,
 uint32_t zlib::crc32(StringRef Buffer) {
   llvm_unreachable("zlib::crc32 is unavailable");
 }
+zlib::BlockCompressor::BlockCompressor(SinkFn Sink, int Level,
+                                       size_t BlockSize) {
+  llvm_unreachable("zlib::BlockCompressor is unavailable");
+}
+void zlib::BlockCompressor::write(StringRef Data) {
+  llvm_unreachable("zlib::BlockCompressor is unavailable");
+}
+Error zlib::BlockCompressor::finish() {
+  llvm_unreachable("zlib::BlockCompressor is unavailable");
+}
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level) {
+  llvm_unreachable("zlib::compressParallel is unavailable");
+}
 #endif
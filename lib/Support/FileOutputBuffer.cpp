@@ -16,6 +16,7 @@
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Memory.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <system_error>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
@@ -37,13 +38,42 @@ public:
                std::unique_ptr<fs::mapped_file_region> Buf)
       : FileOutputBuffer(Path), Buffer(std::move(Buf)), Temp(std::move(Temp)) {}
 
-  uint8_t *getBufferStart() const override { return (uint8_t *)Buffer->data(); }
+  uint8_t *getBufferStart() const override {
+    return Buffer ? (uint8_t *)Buffer->data() : nullptr;
+  }
 
   uint8_t *getBufferEnd() const override {
-    return (uint8_t *)Buffer->data() + Buffer->size();
+    return getBufferStart() + getBufferSize();
   }
 
-  size_t getBufferSize() const override { return Buffer->size(); }
+  size_t getBufferSize() const override { return Buffer ? Buffer->size() : 0; }
+
+  Error resize(size_t NewSize) override {
+#ifdef _WIN32
+    // The mapping extends the file on Windows, see createOnDiskBuffer(), so
+    // the file only needs resizing when it shrinks.
+    bool NeedsResize = NewSize < getBufferSize();
+#else
+    bool NeedsResize = true;
+#endif
+    // The mapping has to go before the file can be resized. An empty file
+    // cannot be mapped, so it stays unmapped until it grows again.
+    Buffer.reset();
+    if (NeedsResize)
+      if (auto EC = fs::resize_file(Temp.FD, NewSize))
+        return errorCodeToError(EC);
+    if (!NewSize)
+      return Error::success();
+
+    std::error_code EC;
+    Buffer = llvm::make_unique<fs::mapped_file_region>(
+        Temp.FD, fs::mapped_file_region::readwrite, NewSize, 0, EC);
+    if (EC) {
+      Buffer.reset();
+      return errorCodeToError(EC);
+    }
+    return Error::success();
+  }
 
   Error commit() override {
     // Unmap buffer, letting OS flush dirty pages to file on disk.
@@ -86,6 +116,17 @@ public:
 
   size_t getBufferSize() const override { return Buffer.size(); }
 
+  Error resize(size_t NewSize) override {
+    std::error_code EC;
+    OwningMemoryBlock NewBuffer(Memory::allocateMappedMemory(
+        NewSize, nullptr, sys::Memory::MF_READ | sys::Memory::MF_WRITE, EC));
+    if (EC)
+      return errorCodeToError(EC);
+    memcpy(NewBuffer.base(), Buffer.base(), std::min(NewSize, Buffer.size()));
+    std::swap(Buffer, NewBuffer);
+    return Error::success();
+  }
+
   Error commit() override {
     if (FinalPath == "-") {
       llvm::outs() << StringRef((const char *)Buffer.base(), Buffer.size());
@@ -189,3 +230,94 @@ FileOutputBuffer::create(StringRef Path, size_t Size, unsigned Flags) {
     return createInMemoryBuffer(Path, Size, Mode);
   }
 }
+
+//===----------------------------------------------------------------------===//
+//  raw_mapped_file_ostream
+//===----------------------------------------------------------------------===//
+
+// The smallest buffer the stream starts out with or grows by. Objects are
+// rarely smaller, and growing a mapping takes a couple of system calls.
+static const size_t MinMappedStreamSize = 64 * 1024;
+
+raw_mapped_file_ostream::raw_mapped_file_ostream(
+    std::unique_ptr<FileOutputBuffer> Buffer)
+    : Buffer(std::move(Buffer)) {
+  reserve(0);
+}
+
+Expected<std::unique_ptr<raw_mapped_file_ostream>>
+raw_mapped_file_ostream::create(StringRef FilePath, size_t SizeHint,
+                                unsigned Flags) {
+  Expected<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
+      FileOutputBuffer::create(FilePath,
+                               std::max(SizeHint, MinMappedStreamSize), Flags);
+  if (!BufferOrErr)
+    return BufferOrErr.takeError();
+  return std::unique_ptr<raw_mapped_file_ostream>(
+      new raw_mapped_file_ostream(std::move(*BufferOrErr)));
+}
+
+raw_mapped_file_ostream::~raw_mapped_file_ostream() {
+  // The file is discarded unless committed, but the stream's buffer must be
+  // empty before it is destroyed.
+  SetUnbuffered();
+}
+
+void raw_mapped_file_ostream::reserve(uint64_t MinSize) {
+  size_t Size = Buffer->getBufferSize();
+  if (MinSize > Size || Pos == Size) {
+    size_t NewSize = std::max<uint64_t>(
+        {MinSize, Size * 2, Pos + MinMappedStreamSize});
+    if (Error E = Buffer->resize(NewSize)) {
+      // Keep accepting writes, but drop them; commit() reports the error.
+      EC = errorToErrorCode(std::move(E));
+      SetUnbuffered();
+      return;
+    }
+    Size = NewSize;
+  }
+  SetBuffer(reinterpret_cast<char *>(Buffer->getBufferStart()) + Pos,
+            Size - Pos);
+}
+
+void raw_mapped_file_ostream::write_impl(const char *Ptr, size_t Size) {
+  if (EC)
+    return;
+  char *Cur = reinterpret_cast<char *>(Buffer->getBufferStart()) + Pos;
+  // Data from the stream's buffer is in place already. Anything else is
+  // written directly, as the stream does for writes that are larger than
+  // its buffer.
+  if (Ptr != Cur) {
+    // Whatever was buffered before this write has been flushed already.
+    reserve(Pos + Size);
+    if (EC)
+      return;
+    Cur = reinterpret_cast<char *>(Buffer->getBufferStart()) + Pos;
+    memcpy(Cur, Ptr, Size);
+  }
+  Pos += Size;
+  reserve(0);
+}
+
+void raw_mapped_file_ostream::pwrite_impl(const char *Ptr, size_t Size,
+                                          uint64_t Offset) {
+  if (EC)
+    return;
+  memcpy(Buffer->getBufferStart() + Offset, Ptr, Size);
+}
+
+void raw_mapped_file_ostream::reserveExtraSpace(uint64_t ExtraSize) {
+  if (EC)
+    return;
+  flush();
+  reserve(Pos + ExtraSize);
+}
+
+Error raw_mapped_file_ostream::commit() {
+  SetUnbuffered();
+  if (EC)
+    return errorCodeToError(EC);
+  if (Error E = Buffer->resize(Pos))
+    return E;
+  return Buffer->commit();
+}
@@ -0,0 +1,146 @@
+//===- MemoryAccounting.cpp - Memory use by subsystem ---------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/MemoryAccounting.h"
+#include "llvm/Support/ErrorHandling.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+using namespace llvm;
+
+bool llvm::detail::MemoryAccountingEnabled = false;
+
+namespace {
+struct CategoryCounters {
+  std::atomic<int64_t> Current{0};
+  /// The peak of the innermost region that is being measured.
+  std::atomic<int64_t> RegionPeak{0};
+  std::atomic<int64_t> ProcessPeak{0};
+};
+} // end anonymous namespace
+
+static CategoryCounters Counters[NumMemoryCategories];
+
+static void updateMax(std::atomic<int64_t> &Max, int64_t Value) {
+  int64_t Prev = Max.load(std::memory_order_relaxed);
+  while (Value > Prev &&
+         !Max.compare_exchange_weak(Prev, Value, std::memory_order_relaxed)) {
+  }
+}
+
+const char *llvm::getMemoryCategoryName(MemoryCategory Category) {
+  switch (Category) {
+  case MemoryCategory::Other:
+    return "Other";
+  case MemoryCategory::IR:
+    return "IR";
+  case MemoryCategory::Metadata:
+    return "Metadata";
+  case MemoryCategory::SCEV:
+    return "SCEV";
+  case MemoryCategory::SelectionDAG:
+    return "SelectionDAG";
+  case MemoryCategory::LiveIntervals:
+    return "LiveIntervals";
+  case MemoryCategory::MachineIR:
+    return "MachineIR";
+  case MemoryCategory::MC:
+    return "MC";
+  }
+  llvm_unreachable("Unknown memory category");
+}
+
+void llvm::detail::recordMemoryUse(MemoryCategory Category, int64_t Bytes) {
+  CategoryCounters &C = Counters[static_cast<unsigned>(Category)];
+  int64_t Current =
+      C.Current.fetch_add(Bytes, std::memory_order_relaxed) + Bytes;
+  if (Bytes > 0) {
+    updateMax(C.RegionPeak, Current);
+    updateMax(C.ProcessPeak, Current);
+  }
+}
+
+bool llvm::isMemoryAccountingEnabledForLayout() {
+  static const bool Enabled = isMemoryAccountingEnabled();
+  return Enabled;
+}
+
+// The size of an accounted object is kept in front of it, in a header that
+// keeps the alignment ::operator new gives.
+static const size_t AccountedHeaderSize = alignof(std::max_align_t);
+
+void *llvm::allocateAccounted(size_t Size, MemoryCategory Category) {
+  if (!isMemoryAccountingEnabledForLayout())
+    return ::operator new(Size);
+  char *Storage =
+      static_cast<char *>(::operator new(Size + AccountedHeaderSize));
+  *reinterpret_cast<size_t *>(Storage) = Size;
+  detail::recordMemoryUse(Category, static_cast<int64_t>(Size));
+  return Storage + AccountedHeaderSize;
+}
+
+void llvm::deallocateAccounted(void *Ptr, MemoryCategory Category) {
+  if (!isMemoryAccountingEnabledForLayout())
+    return ::operator delete(Ptr);
+  char *Storage = static_cast<char *>(Ptr) - AccountedHeaderSize;
+  size_t Size = *reinterpret_cast<size_t *>(Storage);
+  detail::recordMemoryUse(Category, -static_cast<int64_t>(Size));
+  ::operator delete(Storage);
+}
+
+bool MemoryUsage::empty() const {
+  for (unsigned I = 0; I != NumMemoryCategories; ++I)
+    if (Net[I] || Peak[I])
+      return false;
+  return true;
+}
+
+MemoryUsage &MemoryUsage::operator+=(const MemoryUsage &RHS) {
+  for (unsigned I = 0; I != NumMemoryCategories; ++I) {
+    Net[I] += RHS.Net[I];
+    Peak[I] = std::max(Peak[I], RHS.Peak[I]);
+  }
+  return *this;
+}
+
+MemoryRegionStart llvm::beginMemoryRegion() {
+  // The peak of the new region starts at the current use. The peak of the
+  // enclosing region is restored, and updated, when the new one ends.
+  MemoryRegionStart Start;
+  for (unsigned I = 0; I != NumMemoryCategories; ++I) {
+    CategoryCounters &C = Counters[I];
+    Start.Current[I] = C.Current.load(std::memory_order_relaxed);
+    Start.OuterPeak[I] =
+        C.RegionPeak.exchange(Start.Current[I], std::memory_order_relaxed);
+  }
+  return Start;
+}
+
+MemoryUsage llvm::endMemoryRegion(const MemoryRegionStart &Start) {
+  MemoryUsage Usage;
+  for (unsigned I = 0; I != NumMemoryCategories; ++I) {
+    CategoryCounters &C = Counters[I];
+    int64_t Peak = C.RegionPeak.load(std::memory_order_relaxed);
+    Usage.Net[I] = C.Current.load(std::memory_order_relaxed) - Start.Current[I];
+    Usage.Peak[I] = std::max<int64_t>(Peak - Start.Current[I], 0);
+    C.RegionPeak.store(std::max(Peak, Start.OuterPeak[I]),
+                       std::memory_order_relaxed);
+  }
+  return Usage;
+}
+
+MemoryUsage llvm::getProcessMemoryUsage() {
+  MemoryUsage Usage;
+  for (unsigned I = 0; I != NumMemoryCategories; ++I) {
+    Usage.Net[I] = Counters[I].Current.load(std::memory_order_relaxed);
+    Usage.Peak[I] = Counters[I].ProcessPeak.load(std::memory_order_relaxed);
+  }
+  return Usage;
+}
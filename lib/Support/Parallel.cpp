@@ -13,9 +13,16 @@
 
 #include "llvm/Support/Threading.h"
 
+#include <algorithm>
 #include <atomic>
-#include <stack>
+#include <deque>
+#include <memory>
 #include <thread>
+#include <vector>
+
+#if LLVM_ON_UNIX
+#include <unistd.h>
+#endif
 
 using namespace llvm;
 
@@ -25,7 +32,13 @@ namespace {
 class Executor {
 public:
   virtual ~Executor() = default;
-  virtual void add(std::function<void()> func) = 0;
+  /// Run \p func asynchronously. \p Group identifies the tasks that
+  /// runPendingTask may run for a waiter.
+  virtual void add(std::function<void()> func, const void *Group) = 0;
+
+  /// Run the task of \p Group that was added last from the current thread, if
+  /// it has not started yet. Returns false if there is none.
+  virtual bool runPendingTask(const void *Group) { return false; }
 
   static Executor *getDefaultExecutor();
 };
@@ -46,7 +59,7 @@ class ConcRTExecutor : public Executor {
   };
 
 public:
-  virtual void add(std::function<void()> F) {
+  virtual void add(std::function<void()> F, const void *) {
     Concurrency::CurrentScheduler::ScheduleTask(
         Taskish::run, new (concurrency::Alloc(sizeof(Taskish))) Taskish(F));
   }
@@ -58,71 +71,196 @@ Executor *Executor::getDefaultExecutor() {
 }
 
 #else
-/// An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+/// A task queued on a ThreadPoolExecutor, and the group it belongs to.
+struct QueuedTask {
+  std::function<void()> Fn;
+  const void *Group;
+};
+
+/// A queue of tasks owned by one worker of a ThreadPoolExecutor.
+struct WorkQueue {
+  std::mutex Mutex;
+  std::deque<QueuedTask> Tasks;
+};
+
+/// The queue of the worker running on this thread, if any.
+static LLVM_THREAD_LOCAL WorkQueue *LocalQueue = nullptr;
+
+/// An implementation of an Executor that runs closures on a thread pool.
+///
+/// Every worker has its own queue. Tasks spawned on a worker go to its own
+/// queue, which it runs in filo order; this keeps nested work on the thread
+/// that created it. Idle workers steal the oldest task from the other queues,
+/// and tasks added from outside the pool are distributed round-robin.
 class ThreadPoolExecutor : public Executor {
 public:
   explicit ThreadPoolExecutor(unsigned ThreadCount = hardware_concurrency())
       : Done(ThreadCount) {
+    for (unsigned I = 0; I < ThreadCount; ++I)
+      Queues.push_back(llvm::make_unique<WorkQueue>());
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     std::thread([&, ThreadCount] {
-      for (size_t i = 1; i < ThreadCount; ++i) {
-        std::thread([=] { work(); }).detach();
+      for (unsigned I = 1; I < ThreadCount; ++I) {
+        std::thread([=] { work(I); }).detach();
       }
-      work();
+      work(0);
     }).detach();
   }
 
   ~ThreadPoolExecutor() override {
-    std::unique_lock<std::mutex> Lock(Mutex);
+    std::unique_lock<std::mutex> Lock(SleepMutex);
     Stop = true;
     Lock.unlock();
-    Cond.notify_all();
+    SleepCond.notify_all();
     // Wait for ~Latch.
   }
 
-  void add(std::function<void()> F) override {
-    std::unique_lock<std::mutex> Lock(Mutex);
-    WorkStack.push(F);
-    Lock.unlock();
-    Cond.notify_one();
+  void add(std::function<void()> F, const void *Group) override {
+    WorkQueue *Q = LocalQueue;
+    if (!Q)
+      Q = Queues[NextQueue++ % Queues.size()].get();
+    {
+      std::lock_guard<std::mutex> Lock(Q->Mutex);
+      Q->Tasks.push_back({std::move(F), Group});
+    }
+    ++Pending;
+    // A worker about to sleep has incremented Sleeping before it checks
+    // Pending, so either it sees the new task or we see it and wake it up.
+    if (Sleeping) {
+      { std::lock_guard<std::mutex> Lock(SleepMutex); }
+      SleepCond.notify_one();
+    }
+  }
+
+  bool runPendingTask(const void *Group) override {
+    if (!LocalQueue)
+      return false;
+    std::function<void()> Task;
+    {
+      // A group's tasks are spawned on the queue of the thread that waits
+      // for them, but tasks added from outside the pool may sit on top.
+      WorkQueue &Q = *LocalQueue;
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      auto I = std::find_if(Q.Tasks.rbegin(), Q.Tasks.rend(),
+                            [&](const QueuedTask &T) {
+                              return T.Group == Group;
+                            });
+      if (I == Q.Tasks.rend())
+        return false;
+      Task = std::move(I->Fn);
+      Q.Tasks.erase(std::next(I).base());
+      --Pending;
+    }
+    Task();
+    return true;
   }
 
 private:
-  void work() {
+  bool popLocal(WorkQueue &Q, std::function<void()> &Task) {
+    std::lock_guard<std::mutex> Lock(Q.Mutex);
+    if (Q.Tasks.empty())
+      return false;
+    Task = std::move(Q.Tasks.back().Fn);
+    Q.Tasks.pop_back();
+    --Pending;
+    return true;
+  }
+
+  bool steal(unsigned Thief, std::function<void()> &Task) {
+    for (unsigned I = 1, E = Queues.size(); I < E; ++I) {
+      WorkQueue &Q = *Queues[(Thief + I) % E];
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      if (Q.Tasks.empty())
+        continue;
+      Task = std::move(Q.Tasks.front().Fn);
+      Q.Tasks.pop_front();
+      --Pending;
+      return true;
+    }
+    return false;
+  }
+
+  void work(unsigned Index) {
+    LocalQueue = Queues[Index].get();
     while (true) {
-      std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
+      std::function<void()> Task;
+      if (popLocal(*LocalQueue, Task) || steal(Index, Task)) {
+        Task();
+        continue;
+      }
+      std::unique_lock<std::mutex> Lock(SleepMutex);
+      ++Sleeping;
+      SleepCond.wait(Lock, [&] { return Stop || Pending > 0; });
+      --Sleeping;
       if (Stop)
         break;
-      auto Task = WorkStack.top();
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
     }
     Done.dec();
   }
 
+  std::vector<std::unique_ptr<WorkQueue>> Queues;
+  std::atomic<unsigned> NextQueue{0};
+  // The number of queued tasks. It can briefly be lower than that, but never
+  // higher, as tasks are counted after they are queued.
+  std::atomic<int> Pending{0};
+  std::atomic<unsigned> Sleeping{0};
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
-  std::mutex Mutex;
-  std::condition_variable Cond;
+  std::mutex SleepMutex;
+  std::condition_variable SleepCond;
   parallel::detail::Latch Done;
 };
 
+#if LLVM_ON_UNIX
+/// Destroys the default executor at exit, except in a child forked from the
+/// process that created it. The child has none of the workers, so stopping
+/// them or destroying the condition variable they wait on would block
+/// forever.
+struct DefaultExecutorDeleter {
+  pid_t OwnerPID = ::getpid();
+
+  void operator()(ThreadPoolExecutor *E) const {
+    if (::getpid() == OwnerPID)
+      delete E;
+  }
+};
+#endif
+
 Executor *Executor::getDefaultExecutor() {
+#if LLVM_ON_UNIX
+  static std::unique_ptr<ThreadPoolExecutor, DefaultExecutorDeleter> Exec(
+      new ThreadPoolExecutor());
+  return Exec.get();
+#else
   static ThreadPoolExecutor exec;
   return &exec;
+#endif
 }
 #endif
 }
 
+parallel::detail::TaskGroup::~TaskGroup() { sync(); }
+
 void parallel::detail::TaskGroup::spawn(std::function<void()> F) {
   L.inc();
-  Executor::getDefaultExecutor()->add([&, F] {
-    F();
-    L.dec();
-  });
+  Executor::getDefaultExecutor()->add(
+      [&, F] {
+        F();
+        L.dec();
+      },
+      this);
+}
+
+void parallel::detail::TaskGroup::sync() const {
+  // When a parallel algorithm runs inside a task, blocking here would take
+  // its worker away while the tasks it just spawned wait in its queue; with
+  // enough nesting every worker ends up waiting. Run them here instead. Only
+  // this group's own tasks are run: a sibling task could wait in turn, and
+  // the stack would grow with every task in the queue rather than with the
+  // nesting of the algorithms.
+  Executor *E = Executor::getDefaultExecutor();
+  while (!L.isDone() && E->runPendingTask(this))
+    ;
+  L.sync();
 }
 #endif // LLVM_ENABLE_THREADS
@@ -21,11 +21,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/Timer.h"
@@ -47,9 +50,24 @@ static cl::opt<bool> StatsAsJSON("stats-json",
                                  cl::desc("Display statistics as json data"),
                                  cl::Hidden);
 
+static cl::opt<std::string> StatsDeltasFile(
+    "stats-deltas",
+    cl::desc("Write the changes of statistics for each module and function "
+             "to this file as JSON"),
+    cl::value_desc("filename"), cl::Hidden);
+
 static bool Enabled;
 static bool PrintOnExit;
 
+namespace {
+/// The changes of statistics while processing a module or function.
+struct StatisticsDelta {
+  std::string Module;
+  std::string Function;
+  std::vector<std::pair<const Statistic *, int64_t>> Changes;
+};
+} // end anonymous namespace
+
 namespace {
 /// This class is used in a ManagedStatic so that it is created on demand (when
 /// the first statistic is bumped) and destroyed only when llvm_shutdown is
@@ -58,10 +76,15 @@ namespace {
 /// use LLVM.
 class StatisticInfo {
   std::vector<Statistic*> Stats;
+  std::vector<StatisticsDelta> Deltas;
 
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
   friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
+  friend void llvm::RecordStatisticsDelta(StringRef Module, StringRef Function,
+                                          const StatisticsSnapshot &Before);
+
+  void printDeltas();
 
   /// Sort statistics by debugtype,name,description.
   void sort();
@@ -88,6 +111,83 @@ public:
 static ManagedStatic<StatisticInfo> StatInfo;
 static ManagedStatic<sys::SmartMutex<true> > StatLock;
 
+// Statistics are counted in NumShards shards. Each thread picks one when it
+// first bumps a statistic; there are few enough shards that the counters of a
+// statistic can be summed quickly, and enough that threads rarely share one.
+// Within a shard, the counters of all statistics are allocated in blocks, so
+// that the counters bumped by one thread share cache lines with each other
+// rather than with those of other threads.
+static const unsigned NumShards = 32;
+static const unsigned CountersPerBlock = 256;
+static const unsigned BlocksPerShard = 256;
+// Statistics beyond this many are not sharded.
+static const unsigned MaxShardedId = CountersPerBlock * BlocksPerShard;
+
+namespace {
+struct CounterBlock {
+  std::atomic<unsigned> Counters[CountersPerBlock];
+};
+} // end anonymous namespace
+
+static std::atomic<CounterBlock *> Shards[NumShards][BlocksPerShard];
+static std::atomic<unsigned> NextShard;
+// The shard of the current thread plus one, or 0 if it has none yet.
+static LLVM_THREAD_LOCAL unsigned LocalShard;
+// The last Id given to a statistic, guarded by StatLock.
+static unsigned LastId;
+
+/// Return the counter of the statistic \p Id in \p Shard, or null if the
+/// block holding it was not allocated yet.
+static std::atomic<unsigned> *lookupCounter(unsigned Shard, unsigned Id) {
+  CounterBlock *Block =
+      Shards[Shard][Id / CountersPerBlock].load(std::memory_order_acquire);
+  return Block ? &Block->Counters[Id % CountersPerBlock] : nullptr;
+}
+
+std::atomic<unsigned> &Statistic::getCounter() {
+  // Only called after init(), whose acquire of Initialized orders this load
+  // after the store that assigned Id.
+  unsigned Id = this->Id.load(std::memory_order_relaxed);
+  if (Id >= MaxShardedId)
+    return Value;
+  unsigned Shard = LocalShard;
+  if (!Shard)
+    Shard = LocalShard = NextShard++ % NumShards + 1;
+  std::atomic<CounterBlock *> &Slot = Shards[Shard - 1][Id / CountersPerBlock];
+  CounterBlock *Block = Slot.load(std::memory_order_acquire);
+  if (!Block) {
+    // The blocks are never freed, as statistics may still be bumped while
+    // llvm_shutdown runs.
+    CounterBlock *New = new CounterBlock();
+    if (Slot.compare_exchange_strong(Block, New, std::memory_order_acq_rel))
+      Block = New;
+    else
+      delete New;
+  }
+  return Block->Counters[Id % CountersPerBlock];
+}
+
+unsigned Statistic::getValue() const {
+  unsigned Sum = Value.load(std::memory_order_relaxed);
+  unsigned Id = this->Id.load(std::memory_order_acquire);
+  if (Id == 0 || Id >= MaxShardedId)
+    return Sum;
+  for (unsigned Shard = 0; Shard != NumShards; ++Shard)
+    if (std::atomic<unsigned> *Counter = lookupCounter(Shard, Id))
+      Sum += Counter->load(std::memory_order_relaxed);
+  return Sum;
+}
+
+void Statistic::setValue(unsigned Val) {
+  Value.store(Val, std::memory_order_relaxed);
+  unsigned Id = this->Id.load(std::memory_order_acquire);
+  if (Id == 0 || Id >= MaxShardedId)
+    return;
+  for (unsigned Shard = 0; Shard != NumShards; ++Shard)
+    if (std::atomic<unsigned> *Counter = lookupCounter(Shard, Id))
+      Counter->store(0, std::memory_order_relaxed);
+}
+
 /// RegisterStatistic - The first time a statistic is bumped, this method is
 /// called.
 void Statistic::RegisterStatistic() {
@@ -106,8 +206,10 @@ void Statistic::RegisterStatistic() {
     // Check Initialized again after acquiring the lock.
     if (Initialized.load(std::memory_order_relaxed))
       return;
-    if (Stats || Enabled)
+    if (Stats || Enabled || !StatsDeltasFile.empty())
       SI.addStatistic(this);
+    if (Id.load(std::memory_order_relaxed) == 0)
+      Id.store(++LastId, std::memory_order_release);
 
     // Remember we have been registered.
     Initialized.store(true, std::memory_order_release);
@@ -123,6 +225,33 @@ StatisticInfo::StatisticInfo() {
 StatisticInfo::~StatisticInfo() {
   if (::Stats || PrintOnExit)
     llvm::PrintStatistics();
+  if (!StatsDeltasFile.empty())
+    printDeltas();
+}
+
+void StatisticInfo::printDeltas() {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  json::Array Array;
+  for (const StatisticsDelta &Delta : Deltas) {
+    json::Object Changes;
+    for (const auto &Change : Delta.Changes)
+      Changes[(Twine(Change.first->getDebugType()) + "." +
+               Change.first->getName())
+                  .str()] = Change.second;
+    json::Object Entry{{"module", Delta.Module}, {"stats", std::move(Changes)}};
+    if (!Delta.Function.empty())
+      Entry["function"] = Delta.Function;
+    Array.push_back(std::move(Entry));
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(StatsDeltasFile, EC, sys::fs::F_Text);
+  if (EC) {
+    errs() << "Error opening statistics deltas file '" << StatsDeltasFile
+           << "': " << EC.message() << '\n';
+    return;
+  }
+  OS << formatv("{0:2}", json::Value(std::move(Array))) << '\n';
 }
 
 void llvm::EnableStatistics(bool PrintOnExit) {
@@ -134,6 +263,10 @@ bool llvm::AreStatisticsEnabled() {
   return Enabled || Stats;
 }
 
+bool llvm::AreStatisticsDeltasEnabled() {
+  return !StatsDeltasFile.empty();
+}
+
 void StatisticInfo::sort() {
   std::stable_sort(Stats.begin(), Stats.end(),
                    [](const Statistic *LHS, const Statistic *RHS) {
@@ -158,7 +291,7 @@ void StatisticInfo::reset() {
     // Value updates to a statistic that complete before this statement in the
     // iteration for that statistic will be lost as intended.
     Stat->Initialized = false;
-    Stat->Value = 0;
+    Stat->setValue(0);
   }
 
   // Clear the registration list and release the lock once we're done. Any
@@ -265,3 +398,32 @@ const std::vector<std::pair<StringRef, unsigned>> llvm::GetStatistics() {
 void llvm::ResetStatistics() {
   StatInfo->reset();
 }
+
+StatisticsSnapshot llvm::GetStatisticsSnapshot() {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  StatisticsSnapshot Snapshot;
+  for (const Statistic *Stat : StatInfo->statistics())
+    Snapshot.emplace_back(Stat, Stat->getValue());
+  return Snapshot;
+}
+
+void llvm::RecordStatisticsDelta(StringRef Module, StringRef Function,
+                                 const StatisticsSnapshot &Before) {
+  DenseMap<const Statistic *, unsigned> OldValues(Before.begin(),
+                                                  Before.end());
+  StatisticsDelta Delta;
+  Delta.Module = Module;
+  Delta.Function = Function;
+  StatisticInfo &SI = *StatInfo;
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  // Statistics that are not in Before were registered since, so their old
+  // value was 0.
+  for (const Statistic *Stat : SI.statistics()) {
+    int64_t Change = static_cast<int64_t>(Stat->getValue()) -
+                     static_cast<int64_t>(OldValues.lookup(Stat));
+    if (Change)
+      Delta.Changes.emplace_back(Stat, Change);
+  }
+  if (!Delta.Changes.empty())
+    SI.Deltas.push_back(std::move(Delta));
+}
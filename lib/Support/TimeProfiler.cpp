@@ -0,0 +1,275 @@
+//===-- TimeProfiler.cpp - Hierarchical Time Profiler ---------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file Hierarchical time profiler implementation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace llvm {
+
+TimeTraceProfiler *TimeTraceProfilerInstance = nullptr;
+
+typedef duration<steady_clock::rep, steady_clock::period> DurationType;
+typedef std::pair<size_t, DurationType> CountAndDurationType;
+typedef std::pair<std::string, CountAndDurationType>
+    NameAndCountAndDurationType;
+
+namespace {
+
+struct Entry {
+  time_point<steady_clock> Start;
+  DurationType Duration;
+  std::string Name;
+  std::string Detail;
+  unsigned Tid = 0;
+
+  Entry(time_point<steady_clock> &&S, DurationType &&D, std::string &&N,
+        std::string &&Dt)
+      : Start(std::move(S)), Duration(std::move(D)), Name(std::move(N)),
+        Detail(std::move(Dt)) {}
+};
+
+/// The sections of one thread. Only that thread touches them until the trace
+/// is written.
+struct ThreadTrace {
+  /// Small sequential number of the thread, used as its trace "tid".
+  unsigned Tid;
+  SmallVector<Entry, 16> Stack;
+  std::vector<Entry> Entries;
+  StringMap<CountAndDurationType> CountAndTotalPerName;
+};
+
+} // end anonymous namespace
+
+static std::atomic<unsigned> NextProfilerID;
+// The profiler the current thread's trace belongs to, and the trace. A
+// profiler that replaces a cleaned up one gets a new ID, so stale traces are
+// never used.
+static LLVM_THREAD_LOCAL unsigned ThreadTraceOwner;
+static LLVM_THREAD_LOCAL ThreadTrace *CurrentThreadTrace;
+
+/// The profiler may be entered from several threads at once, e.g. by the
+/// ThinLTO backends or the parallel code generator. Every thread records
+/// into its own ThreadTrace, so beginning and ending sections takes no lock;
+/// the lock is only taken the first time a thread records something, and
+/// when the traces are written.
+struct TimeTraceProfiler {
+  TimeTraceProfiler(unsigned TimeTraceGranularity)
+      : ID(++NextProfilerID), StartTime(steady_clock::now()),
+        TimeTraceGranularity(TimeTraceGranularity) {}
+
+  void begin(std::string Name, llvm::function_ref<std::string()> Detail) {
+    std::string D = Detail();
+    getThreadTrace().Stack.emplace_back(steady_clock::now(), DurationType{},
+                                        std::move(Name), std::move(D));
+  }
+
+  void end() {
+    auto Now = steady_clock::now();
+    ThreadTrace &T = getThreadTrace();
+    auto &Stack = T.Stack;
+    assert(!Stack.empty() && "Must call begin() first");
+    auto &E = Stack.back();
+    E.Duration = Now - E.Start;
+    E.Tid = T.Tid;
+
+    // Only include sections at least TimeTraceGranularity microseconds long.
+    if (duration_cast<microseconds>(E.Duration).count() >=
+        TimeTraceGranularity)
+      T.Entries.emplace_back(E);
+
+    // Track total time taken by each "name", but only the topmost levels of
+    // them; e.g. if a pass manager runs nested pass managers, we only want to
+    // add the topmost one. "topmost" happens to be the ones that don't have
+    // any currently open entries above itself.
+    if (std::find_if(++Stack.rbegin(), Stack.rend(), [&](const Entry &Val) {
+          return Val.Name == E.Name;
+        }) == Stack.rend()) {
+      auto &CountAndTotal = T.CountAndTotalPerName[E.Name];
+      CountAndTotal.first++;
+      CountAndTotal.second += E.Duration;
+    }
+
+    Stack.pop_back();
+  }
+
+  void write(raw_ostream &OS) {
+    std::lock_guard<std::mutex> Lock(Mu);
+    assert(llvm::all_of(Threads,
+                        [](const std::unique_ptr<ThreadTrace> &T) {
+                          return T->Stack.empty();
+                        }) &&
+           "All profiler sections should be ended when calling write");
+
+    json::Array Events;
+
+    // Emit all events for the main flame graph.
+    StringMap<CountAndDurationType> CountAndTotalPerName;
+    for (const auto &T : Threads) {
+      for (const auto &E : T->Entries) {
+        auto StartUs =
+            duration_cast<microseconds>(E.Start - StartTime).count();
+        auto DurUs = duration_cast<microseconds>(E.Duration).count();
+        Events.emplace_back(json::Object{
+            {"pid", 1},
+            {"tid", E.Tid},
+            {"ph", "X"},
+            {"ts", StartUs},
+            {"dur", DurUs},
+            {"name", E.Name},
+            {"args", json::Object{{"detail", E.Detail}}},
+        });
+      }
+      for (const auto &Total : T->CountAndTotalPerName) {
+        auto &CountAndTotal = CountAndTotalPerName[Total.getKey()];
+        CountAndTotal.first += Total.getValue().first;
+        CountAndTotal.second += Total.getValue().second;
+      }
+    }
+
+    // Emit totals by section name as additional "thread" events, sorted from
+    // longest one. They are numbered after the real threads.
+    unsigned Tid = Threads.size();
+    std::vector<NameAndCountAndDurationType> SortedTotals;
+    SortedTotals.reserve(CountAndTotalPerName.size());
+    for (const auto &E : CountAndTotalPerName)
+      SortedTotals.emplace_back(E.getKey(), E.getValue());
+
+    llvm::sort(SortedTotals.begin(), SortedTotals.end(),
+               [](const NameAndCountAndDurationType &A,
+                  const NameAndCountAndDurationType &B) {
+                 return A.second.second > B.second.second;
+               });
+    for (const auto &E : SortedTotals) {
+      auto DurUs = duration_cast<microseconds>(E.second.second).count();
+      auto Count = E.second.first;
+      Events.emplace_back(json::Object{
+          {"pid", 1},
+          {"tid", Tid},
+          {"ph", "X"},
+          {"ts", 0},
+          {"dur", DurUs},
+          {"name", "Total " + E.first},
+          {"args", json::Object{{"count", static_cast<int64_t>(Count)},
+                                {"avg ms",
+                                 static_cast<int64_t>(DurUs / Count / 1000)}}},
+      });
+      ++Tid;
+    }
+
+    // Emit metadata event with process name.
+    Events.emplace_back(json::Object{
+        {"cat", ""},
+        {"pid", 1},
+        {"tid", 0},
+        {"ts", 0},
+        {"ph", "M"},
+        {"name", "process_name"},
+        {"args", json::Object{{"name", "llvm"}}},
+    });
+
+    OS << formatv("{0:2}", json::Value(json::Object(
+                               {{"traceEvents", std::move(Events)}})));
+  }
+
+private:
+  /// Returns the trace of the calling thread, creating it on first use.
+  ThreadTrace &getThreadTrace() {
+    if (ThreadTraceOwner != ID) {
+      std::lock_guard<std::mutex> Lock(Mu);
+      Threads.push_back(llvm::make_unique<ThreadTrace>());
+      Threads.back()->Tid = Threads.size() - 1;
+      CurrentThreadTrace = Threads.back().get();
+      ThreadTraceOwner = ID;
+    }
+    return *CurrentThreadTrace;
+  }
+
+  const unsigned ID;
+  std::mutex Mu;
+  std::vector<std::unique_ptr<ThreadTrace>> Threads;
+  time_point<steady_clock> StartTime;
+
+  // Minimum time granularity (in microseconds)
+  unsigned TimeTraceGranularity;
+};
+
+void timeTraceProfilerInitialize(unsigned TimeTraceGranularity) {
+  assert(TimeTraceProfilerInstance == nullptr &&
+         "Profiler should not be initialized");
+  TimeTraceProfilerInstance = new TimeTraceProfiler(TimeTraceGranularity);
+}
+
+void timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance != nullptr &&
+         "Profiler object can't be null");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+bool timeTraceProfilerWrite(StringRef PreferredFileName,
+                            StringRef FallbackFileName) {
+  assert(TimeTraceProfilerInstance != nullptr &&
+         "Profiler object can't be null");
+
+  std::string Path = PreferredFileName;
+  if (Path.empty()) {
+    if (FallbackFileName == "-")
+      Path = "out";
+    else
+      Path = FallbackFileName;
+    Path += ".time-trace";
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_Text);
+  if (EC)
+    return false;
+
+  timeTraceProfilerWrite(OS);
+  return true;
+}
+
+void timeTraceProfilerBegin(StringRef Name, StringRef Detail) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->begin(Name, [&]() { return Detail.str(); });
+}
+
+void timeTraceProfilerBegin(StringRef Name,
+                            llvm::function_ref<std::string()> Detail) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->begin(Name, Detail);
+}
+
+void timeTraceProfilerEnd() {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->end();
+}
+
+} // namespace llvm
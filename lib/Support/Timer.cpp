@@ -40,10 +40,10 @@ static std::string &getLibSupportInfoOutputFilename() {
 static ManagedStatic<sys::SmartMutex<true> > TimerLock;
 
 namespace {
-  static cl::opt<bool>
+  static cl::opt<bool, true>
   TrackSpace("track-memory", cl::desc("Enable -time-passes memory "
                                       "tracking (this may be slow)"),
-             cl::Hidden);
+             cl::Hidden, cl::location(detail::MemoryAccountingEnabled));
 
   static cl::opt<std::string, true>
   InfoOutputFilename("info-output-file", cl::value_desc("filename"),
@@ -133,6 +133,9 @@ TimeRecord TimeRecord::getCurrentTime(bool Start) {
 void Timer::startTimer() {
   assert(!Running && "Cannot start a running timer");
   Running = Triggered = true;
+  AccountingMemory = isMemoryAccountingEnabled();
+  if (AccountingMemory)
+    MemoryStart = beginMemoryRegion();
   StartTime = TimeRecord::getCurrentTime(true);
 }
 
@@ -141,6 +144,8 @@ void Timer::stopTimer() {
   Running = false;
   Time += TimeRecord::getCurrentTime(false);
   Time -= StartTime;
+  if (AccountingMemory)
+    Time.addMemoryUsage(endMemoryRegion(MemoryStart));
 }
 
 void Timer::clear() {
@@ -336,6 +341,26 @@ void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
 
   Total.print(Total, OS);
   OS << "Total\n\n";
+
+  // With -track-memory, break the memory use of each timer down by subsystem.
+  // The peak is the most memory in use above what was in use when the timer
+  // was started.
+  if (!Total.getMemoryUsage().empty()) {
+    OS << "  ---Net Bytes---  ---Peak Bytes---  ---Category---  --- Name ---\n";
+    for (const PrintRecord &Record : make_range(TimersToPrint.rbegin(),
+                                                TimersToPrint.rend())) {
+      const MemoryUsage &Usage = Record.Time.getMemoryUsage();
+      for (unsigned I = 0; I != NumMemoryCategories; ++I) {
+        if (!Usage.Net[I] && !Usage.Peak[I])
+          continue;
+        OS << format("  %15" PRId64 "  %16" PRId64 "  %-14s  ", Usage.Net[I],
+                     Usage.Peak[I],
+                     getMemoryCategoryName(static_cast<MemoryCategory>(I)))
+           << Record.Description << '\n';
+      }
+    }
+    OS << '\n';
+  }
   OS.flush();
 
   TimersToPrint.clear();
@@ -414,6 +439,18 @@ const char *TimerGroup::printJSONValues(raw_ostream &OS, const char *delim) {
       OS << delim;
       printJSONValue(OS, R, ".mem", T.getMemUsed());
     }
+    const MemoryUsage &Usage = T.getMemoryUsage();
+    for (unsigned I = 0; I != NumMemoryCategories; ++I) {
+      if (!Usage.Net[I] && !Usage.Peak[I])
+        continue;
+      std::string Suffix =
+          std::string(".mem.") +
+          getMemoryCategoryName(static_cast<MemoryCategory>(I));
+      OS << delim;
+      printJSONValue(OS, R, (Suffix + ".net").c_str(), Usage.Net[I]);
+      OS << delim;
+      printJSONValue(OS, R, (Suffix + ".peak").c_str(), Usage.Peak[I]);
+    }
   }
   TimersToPrint.clear();
   return delim;
@@ -12,14 +12,17 @@
 
 #include "llvm/Transforms/IPO/FunctionImport.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
@@ -41,6 +44,9 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO/Internalize.h"
@@ -71,6 +77,8 @@ STATISTIC(NumImportedFunctions, "Number of functions imported in backend");
 STATISTIC(NumImportedGlobalVars,
           "Number of global variables imported in backend");
 STATISTIC(NumImportedModules, "Number of modules imported from");
+STATISTIC(NumImportListsReused,
+          "Number of import lists reused from the import cache");
 STATISTIC(NumDeadSymbols, "Number of dead stripped symbols in index");
 STATISTIC(NumLiveSymbols, "Number of live symbols in index");
 
@@ -262,6 +270,28 @@ namespace {
 using EdgeInfo = std::tuple<const FunctionSummary *, unsigned /* Threshold */,
                             GlobalValue::GUID>;
 
+/// The parts of the index that the import list of a module was computed from,
+/// recorded so that the list can be reused by a later link if none of them
+/// changed.
+struct ImportDependencies {
+  /// The modules that provided a summary considered for importing.
+  StringSet<> Modules;
+  /// GUIDs considered for importing that had no summary at all, mapped to the
+  /// GUID of the local they resolved to through its original name (or 0). A
+  /// later link that adds a definition or such a local must recompute.
+  std::map<GlobalValue::GUID, GlobalValue::GUID> MissingGUIDs;
+
+  void addCandidates(const ModuleSummaryIndex &Index, ValueInfo VI) {
+    if (VI.getSummaryList().empty()) {
+      MissingGUIDs.emplace(VI.getGUID(),
+                           Index.getGUIDFromOriginalID(VI.getGUID()));
+      return;
+    }
+    for (auto &Summary : VI.getSummaryList())
+      Modules.insert(Summary->modulePath());
+  }
+};
+
 } // anonymous namespace
 
 static ValueInfo
@@ -280,15 +310,19 @@ updateValueInfoForIndirectCalls(const ModuleSummaryIndex &Index, ValueInfo VI) {
 }
 
 static void computeImportForReferencedGlobals(
-    const FunctionSummary &Summary, const GVSummaryMapTy &DefinedGVSummaries,
+    const FunctionSummary &Summary, const ModuleSummaryIndex &Index,
+    const GVSummaryMapTy &DefinedGVSummaries,
     FunctionImporter::ImportMapTy &ImportList,
-    StringMap<FunctionImporter::ExportSetTy> *ExportLists) {
+    StringMap<FunctionImporter::ExportSetTy> *ExportLists,
+    ImportDependencies *Deps) {
   for (auto &VI : Summary.refs()) {
     if (DefinedGVSummaries.count(VI.getGUID())) {
       LLVM_DEBUG(
           dbgs() << "Ref ignored! Target already in destination module.\n");
       continue;
     }
+    if (Deps)
+      Deps->addCandidates(Index, VI);
 
     LLVM_DEBUG(dbgs() << " ref -> " << VI << "\n");
 
@@ -350,9 +384,10 @@ static void computeImportForFunction(
     SmallVectorImpl<EdgeInfo> &Worklist,
     FunctionImporter::ImportMapTy &ImportList,
     StringMap<FunctionImporter::ExportSetTy> *ExportLists,
-    FunctionImporter::ImportThresholdsTy &ImportThresholds) {
-  computeImportForReferencedGlobals(Summary, DefinedGVSummaries, ImportList,
-                                    ExportLists);
+    FunctionImporter::ImportThresholdsTy &ImportThresholds,
+    ImportDependencies *Deps) {
+  computeImportForReferencedGlobals(Summary, Index, DefinedGVSummaries,
+                                    ImportList, ExportLists, Deps);
   static int ImportCount = 0;
   for (auto &Edge : Summary.calls()) {
     ValueInfo VI = Edge.first;
@@ -365,6 +400,8 @@ static void computeImportForFunction(
       continue;
     }
 
+    if (Deps && VI.getSummaryList().empty())
+      Deps->addCandidates(Index, VI);
     VI = updateValueInfoForIndirectCalls(Index, VI);
     if (!VI)
       continue;
@@ -373,6 +410,8 @@ static void computeImportForFunction(
       LLVM_DEBUG(dbgs() << "ignored! Target already in destination module.\n");
       continue;
     }
+    if (Deps)
+      Deps->addCandidates(Index, VI);
 
     auto GetBonusMultiplier = [](CalleeInfo::HotnessType Hotness) -> float {
       if (Hotness == CalleeInfo::HotnessType::Hot)
@@ -525,7 +564,8 @@ static void computeImportForFunction(
 static void ComputeImportForModule(
     const GVSummaryMapTy &DefinedGVSummaries, const ModuleSummaryIndex &Index,
     StringRef ModName, FunctionImporter::ImportMapTy &ImportList,
-    StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr) {
+    StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr,
+    ImportDependencies *Deps = nullptr) {
   // Worklist contains the list of function imported in this module, for which
   // we will analyse the callees and may import further down the callgraph.
   SmallVector<EdgeInfo, 128> Worklist;
@@ -551,7 +591,7 @@ static void ComputeImportForModule(
     LLVM_DEBUG(dbgs() << "Initialize import for " << VI << "\n");
     computeImportForFunction(*FuncSummary, Index, ImportInstrLimit,
                              DefinedGVSummaries, Worklist, ImportList,
-                             ExportLists, ImportThresholds);
+                             ExportLists, ImportThresholds, Deps);
   }
 
   // Process the newly imported functions and add callees to the worklist.
@@ -562,7 +602,7 @@ static void ComputeImportForModule(
 
     computeImportForFunction(*Summary, Index, Threshold, DefinedGVSummaries,
                              Worklist, ImportList, ExportLists,
-                             ImportThresholds);
+                             ImportThresholds, Deps);
   }
 
   // Print stats about functions considered but rejected for importing
@@ -614,22 +654,355 @@ static unsigned numGlobalVarSummaries(const ModuleSummaryIndex &Index,
 }
 #endif
 
+// Mark the symbols in \p ImportList as exported from their source modules,
+// as computeImportForFunction and computeImportForReferencedGlobals do when
+// they decide to import them.
+static void
+addImportsToExportLists(const ModuleSummaryIndex &Index,
+                        const FunctionImporter::ImportMapTy &ImportList,
+                        StringMap<FunctionImporter::ExportSetTy> &ExportLists) {
+  for (auto &Src : ImportList) {
+    auto &ExportList = ExportLists[Src.first()];
+    for (GlobalValue::GUID GUID : Src.second) {
+      ExportList.insert(GUID);
+      GlobalValueSummary *S = Index.findSummaryInModule(GUID, Src.first());
+      auto *FS = S ? dyn_cast<FunctionSummary>(S->getBaseObject()) : nullptr;
+      if (!FS)
+        continue;
+      for (auto &Edge : FS->calls())
+        ExportList.insert(Edge.first.getGUID());
+      for (auto &Ref : FS->refs())
+        ExportList.insert(Ref.getGUID());
+    }
+  }
+}
+
+namespace {
+
+/// The import lists of a previous thin link, together with what each of them
+/// was computed from. See ComputeCrossModuleImport.
+class ImportCache {
+  struct Entry {
+    std::string Key;
+    std::vector<std::string> Dependencies;
+    std::map<GlobalValue::GUID, GlobalValue::GUID> MissingGUIDs;
+    FunctionImporter::ImportMapTy ImportList;
+  };
+  /// The entries written by the previous link.
+  StringMap<Entry> Entries;
+  /// The entries computed or reused in this link.
+  StringMap<Entry> NewEntries;
+  /// The keys of the modules in the current link.
+  StringMap<std::string> CurrentKeys;
+  /// Modules whose summaries changed, or that define a GUID that a changed
+  /// module also defines.
+  StringSet<> Changed;
+
+  static std::string getOptionsKey();
+  static std::string getModuleKey(const ModuleSummaryIndex &Index,
+                                  StringRef ModulePath,
+                                  const GVSummaryMapTy &DefinedGVSummaries);
+
+public:
+  /// Compute the keys of the modules in the current link.
+  explicit ImportCache(
+      const ModuleSummaryIndex &Index,
+      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries);
+
+  /// Load the entries of a previous link from \p Path. A missing or
+  /// unreadable cache, or one written with different import options, is
+  /// treated as empty.
+  void load(StringRef Path);
+
+  /// Write the entries for the current link to \p Path.
+  void save(StringRef Path) const;
+
+  /// Determine which modules changed since the cache was written.
+  void computeChangedModules(
+      const ModuleSummaryIndex &Index,
+      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries);
+
+  /// If none of the inputs of the import list of \p ModulePath changed since
+  /// the previous link, carry the list over to this link and return it.
+  /// Otherwise return null.
+  const FunctionImporter::ImportMapTy *reuse(const ModuleSummaryIndex &Index,
+                                             StringRef ModulePath);
+
+  /// Record the import list computed for \p ModulePath in this link.
+  void insert(StringRef ModulePath, const ImportDependencies &Deps,
+              const FunctionImporter::ImportMapTy &ImportList);
+};
+
+} // anonymous namespace
+
+std::string ImportCache::getOptionsKey() {
+  std::string Key;
+  raw_string_ostream OS(Key);
+  OS << LLVM_VERSION_STRING << ' ' << ImportInstrLimit << ' '
+     << ImportInstrFactor << ' ' << ImportHotInstrFactor << ' '
+     << ImportHotMultiplier << ' ' << ImportCriticalMultiplier << ' '
+     << ImportColdMultiplier;
+  return OS.str();
+}
+
+// The import decisions that depend on a module's summaries are determined by
+// the module's contents, which its hash covers, and by the liveness the thin
+// link computed for its symbols. Modules without a hash get an empty key and
+// never compare equal.
+std::string
+ImportCache::getModuleKey(const ModuleSummaryIndex &Index,
+                          StringRef ModulePath,
+                          const GVSummaryMapTy &DefinedGVSummaries) {
+  auto It = Index.modulePaths().find(ModulePath);
+  if (It == Index.modulePaths().end())
+    return "";
+  const ModuleHash &Hash = It->second.second;
+  if (llvm::all_of(Hash, [](uint32_t W) { return W == 0; }))
+    return "";
+
+  SHA1 Hasher;
+  Hasher.update(ArrayRef<uint8_t>((const uint8_t *)&Hash[0], sizeof(Hash)));
+  std::vector<GlobalValue::GUID> Live;
+  for (auto &GVSummary : DefinedGVSummaries)
+    if (Index.isGlobalValueLive(GVSummary.second))
+      Live.push_back(GVSummary.first);
+  llvm::sort(Live);
+  Hasher.update(ArrayRef<uint8_t>((const uint8_t *)Live.data(),
+                                  Live.size() * sizeof(GlobalValue::GUID)));
+  return toHex(Hasher.result());
+}
+
+ImportCache::ImportCache(
+    const ModuleSummaryIndex &Index,
+    const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries) {
+  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries)
+    CurrentKeys[DefinedGVSummaries.first()] = getModuleKey(
+        Index, DefinedGVSummaries.first(), DefinedGVSummaries.second);
+}
+
+// GUIDs are stored as int64_t, the integer type of json::Value.
+static json::Array guidsToJSON(const FunctionImporter::FunctionsToImportTy &S) {
+  std::vector<GlobalValue::GUID> Sorted(S.begin(), S.end());
+  llvm::sort(Sorted);
+  json::Array A;
+  for (GlobalValue::GUID G : Sorted)
+    A.push_back(static_cast<int64_t>(G));
+  return A;
+}
+
+void ImportCache::load(StringRef Path) {
+  auto BufferOrErr = MemoryBuffer::getFile(Path);
+  if (!BufferOrErr)
+    return;
+  Expected<json::Value> V = json::parse((*BufferOrErr)->getBuffer());
+  if (!V) {
+    consumeError(V.takeError());
+    return;
+  }
+  const json::Object *Root = V->getAsObject();
+  if (!Root || Root->getString("options") != StringRef(getOptionsKey()))
+    return;
+  const json::Array *Modules = Root->getArray("modules");
+  if (!Modules)
+    return;
+
+  // The cache is only an optimization, so drop anything malformed.
+  auto GetGUID = [](const json::Value &V, GlobalValue::GUID &G) {
+    if (auto I = V.getAsInteger()) {
+      G = static_cast<GlobalValue::GUID>(*I);
+      return true;
+    }
+    return false;
+  };
+  auto ParseEntry = [&](const json::Object &O, Entry &E) {
+    auto Key = O.getString("key");
+    const json::Array *Deps = O.getArray("deps");
+    const json::Array *Missing = O.getArray("missing");
+    const json::Object *Imports = O.getObject("imports");
+    if (!Key || !Deps || !Missing || !Imports)
+      return false;
+    E.Key = *Key;
+    for (const json::Value &D : *Deps) {
+      auto S = D.getAsString();
+      if (!S)
+        return false;
+      E.Dependencies.push_back(*S);
+    }
+    for (const json::Value &M : *Missing) {
+      const json::Array *Pair = M.getAsArray();
+      GlobalValue::GUID G, Mapped;
+      if (!Pair || Pair->size() != 2 || !GetGUID((*Pair)[0], G) ||
+          !GetGUID((*Pair)[1], Mapped))
+        return false;
+      E.MissingGUIDs[G] = Mapped;
+    }
+    for (auto &Src : *Imports) {
+      const json::Array *GUIDs = Src.second.getAsArray();
+      if (!GUIDs)
+        return false;
+      auto &Functions = E.ImportList[Src.first.str()];
+      for (const json::Value &GV : *GUIDs) {
+        GlobalValue::GUID G;
+        if (!GetGUID(GV, G))
+          return false;
+        Functions.insert(G);
+      }
+    }
+    return true;
+  };
+
+  for (const json::Value &M : *Modules) {
+    const json::Object *O = M.getAsObject();
+    if (!O)
+      continue;
+    auto Path = O->getString("path");
+    Entry E;
+    if (Path && ParseEntry(*O, E))
+      Entries[*Path] = std::move(E);
+  }
+}
+
+void ImportCache::save(StringRef Path) const {
+  // Module paths are stored as JSON strings, which must be UTF-8. The paths
+  // of dependencies and source modules are all module paths of this link.
+  for (auto &K : CurrentKeys)
+    if (!json::isUTF8(K.first()))
+      return;
+
+  json::Array Modules;
+  std::vector<StringRef> Paths;
+  for (auto &E : NewEntries)
+    Paths.push_back(E.first());
+  llvm::sort(Paths);
+  for (StringRef P : Paths) {
+    const Entry &E = NewEntries.find(P)->second;
+    json::Array Missing;
+    for (auto &M : E.MissingGUIDs)
+      Missing.push_back(json::Array{static_cast<int64_t>(M.first),
+                                    static_cast<int64_t>(M.second)});
+    json::Object Imports;
+    for (auto &Src : E.ImportList)
+      Imports[Src.first()] = guidsToJSON(Src.second);
+    Modules.push_back(json::Object{{"path", P},
+                                   {"key", E.Key},
+                                   {"deps", json::Array(E.Dependencies)},
+                                   {"missing", std::move(Missing)},
+                                   {"imports", std::move(Imports)}});
+  }
+
+  // Write to a temporary file first, so that a concurrent or interrupted link
+  // never leaves a partially written cache behind.
+  Expected<sys::fs::TempFile> Temp =
+      sys::fs::TempFile::create(Path + ".tmp%%%%%%");
+  if (!Temp) {
+    consumeError(Temp.takeError());
+    return;
+  }
+  {
+    raw_fd_ostream OS(Temp->FD, /*shouldClose=*/false);
+    OS << json::Value(json::Object{{"options", getOptionsKey()},
+                                   {"modules", std::move(Modules)}});
+  }
+  if (Error E = Temp->keep(Path)) {
+    consumeError(std::move(E));
+    consumeError(Temp->discard());
+  }
+}
+
+void ImportCache::computeChangedModules(
+    const ModuleSummaryIndex &Index,
+    const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries) {
+  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
+    StringRef ModulePath = DefinedGVSummaries.first();
+    const std::string &Key = CurrentKeys[ModulePath];
+    auto It = Entries.find(ModulePath);
+    if (!Key.empty() && It != Entries.end() && It->second.Key == Key)
+      continue;
+    Changed.insert(ModulePath);
+    // A summary list that a changed module is part of may also have gained
+    // or lost that module's entry. Treat the other modules in the list as
+    // changed too, so that importers that examined the list recompute it.
+    for (auto &GVSummary : DefinedGVSummaries.second)
+      for (auto &Summary :
+           Index.getValueInfo(GVSummary.first).getSummaryList())
+        Changed.insert(Summary->modulePath());
+  }
+}
+
+const FunctionImporter::ImportMapTy *
+ImportCache::reuse(const ModuleSummaryIndex &Index, StringRef ModulePath) {
+  auto It = Entries.find(ModulePath);
+  if (It == Entries.end() || Changed.count(ModulePath))
+    return nullptr;
+  const Entry &E = It->second;
+  for (const std::string &Dep : E.Dependencies)
+    if (Changed.count(Dep) || !CurrentKeys.count(Dep))
+      return nullptr;
+  for (auto &M : E.MissingGUIDs) {
+    ValueInfo VI = Index.getValueInfo(M.first);
+    if ((VI && !VI.getSummaryList().empty()) ||
+        Index.getGUIDFromOriginalID(M.first) != M.second)
+      return nullptr;
+  }
+  return &(NewEntries[ModulePath] = E).ImportList;
+}
+
+void ImportCache::insert(StringRef ModulePath, const ImportDependencies &Deps,
+                         const FunctionImporter::ImportMapTy &ImportList) {
+  Entry &E = NewEntries[ModulePath];
+  E.Key = CurrentKeys.lookup(ModulePath);
+  for (auto &Dep : Deps.Modules)
+    E.Dependencies.push_back(Dep.first());
+  llvm::sort(E.Dependencies);
+  E.MissingGUIDs = Deps.MissingGUIDs;
+  for (auto &Src : ImportList)
+    E.ImportList[Src.first()] = Src.second;
+}
+
 /// Compute all the import and export for every module using the Index.
 void llvm::ComputeCrossModuleImport(
     const ModuleSummaryIndex &Index,
     const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
     StringMap<FunctionImporter::ImportMapTy> &ImportLists,
-    StringMap<FunctionImporter::ExportSetTy> &ExportLists) {
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists,
+    StringRef ImportCachePath) {
+  // The import cutoff is global to the link and failure printing needs the
+  // full computation, so neither can work from cached lists.
+  Optional<ImportCache> Cache;
+  if (!ImportCachePath.empty() && ImportCutoff < 0 && !PrintImportFailures) {
+    Cache.emplace(Index, ModuleToDefinedGVSummaries);
+    Cache->load(ImportCachePath);
+    Cache->computeChangedModules(Index, ModuleToDefinedGVSummaries);
+  }
+
   // For each module that has function defined, compute the import/export lists.
   for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
     auto &ImportList = ImportLists[DefinedGVSummaries.first()];
+    if (Cache) {
+      if (auto *CachedList = Cache->reuse(Index, DefinedGVSummaries.first())) {
+        LLVM_DEBUG(dbgs() << "Reusing import for Module '"
+                          << DefinedGVSummaries.first() << "'\n");
+        ++NumImportListsReused;
+        addImportsToExportLists(Index, *CachedList, ExportLists);
+        for (auto &Src : *CachedList)
+          ImportList[Src.first()] = Src.second;
+        continue;
+      }
+    }
+
     LLVM_DEBUG(dbgs() << "Computing import for Module '"
                       << DefinedGVSummaries.first() << "'\n");
+    ImportDependencies Deps;
     ComputeImportForModule(DefinedGVSummaries.second, Index,
                            DefinedGVSummaries.first(), ImportList,
-                           &ExportLists);
+                           &ExportLists, Cache ? &Deps : nullptr);
+    if (Cache)
+      Cache->insert(DefinedGVSummaries.first(), Deps, ImportList);
   }
 
+  if (Cache)
+    Cache->save(ImportCachePath);
+
   // When computing imports we added all GUIDs referenced by anything
   // imported from the module to its ExportList. Now we prune each ExportList
   // of any not defined in that module. This is more efficient than checking
@@ -91,12 +91,24 @@ static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
   }
 }
 
+// Returns the cost of code generating GV, used to balance the partitions when
+// splitting by code size. Every definition costs at least one, so that data
+// is spread out as well.
+static unsigned getCodeGenCost(const GlobalValue *GV) {
+  if (const Function *F = dyn_cast<Function>(GV))
+    return std::max(F->getInstructionCount(), 1u);
+  return 1;
+}
+
 // Find partitions for module in the way that no locals need to be
 // globalized.
 // Try to balance pack those partitions into N files since this roughly equals
-// thread balancing for the backend codegen step.
+// thread balancing for the backend codegen step. If BalanceByCodeSize is set,
+// every definition goes through the balancing (rather than only the clusters
+// that have to stay together) and clusters are weighed by their instruction
+// count rather than by the number of globals in them.
 static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
-                           unsigned N) {
+                           unsigned N, bool BalanceByCodeSize) {
   // At this point module should have the proper mix of globals and locals.
   // As we attempt to partition this module, we must not change any
   // locals to globals.
@@ -105,13 +117,18 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   ClusterMapType GVtoClusterMap;
   ComdatMembersType ComdatMembers;
 
-  auto recordGVSet = [&GVtoClusterMap, &ComdatMembers](GlobalValue &GV) {
+  auto recordGVSet = [&](GlobalValue &GV) {
     if (GV.isDeclaration())
       return;
 
     if (!GV.hasName())
       GV.setName("__llvmsplit_unnamed");
 
+    // Give each definition its own cluster, so that it is placed by the
+    // balancing below rather than by the MD5-based partitioning.
+    if (BalanceByCodeSize)
+      GVtoClusterMap.insert(&GV);
+
     // Comdat groups must not be partitioned. For comdat groups that contain
     // locals, record all their members here so we can keep them together.
     // Comdat groups that only contain external globals are already handled by
@@ -174,11 +191,21 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   // To guarantee determinism, we have to sort SCC according to size.
   // When size is the same, use leader's name.
   for (ClusterMapType::iterator I = GVtoClusterMap.begin(),
-                                E = GVtoClusterMap.end(); I != E; ++I)
-    if (I->isLeader())
-      Sets.push_back(
-          std::make_pair(std::distance(GVtoClusterMap.member_begin(I),
-                                       GVtoClusterMap.member_end()), I));
+                                E = GVtoClusterMap.end(); I != E; ++I) {
+    if (!I->isLeader())
+      continue;
+    unsigned Size = 0;
+    if (BalanceByCodeSize) {
+      for (ClusterMapType::member_iterator MI = GVtoClusterMap.member_begin(I),
+                                           ME = GVtoClusterMap.member_end();
+           MI != ME; ++MI)
+        Size += getCodeGenCost(*MI);
+    } else {
+      Size = std::distance(GVtoClusterMap.member_begin(I),
+                           GVtoClusterMap.member_end());
+    }
+    Sets.push_back(std::make_pair(Size, I));
+  }
 
   llvm::sort(Sets, [](const SortType &a, const SortType &b) {
     if (a.first == b.first)
@@ -205,8 +232,8 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
                         << ((*MI)->hasLocalLinkage() ? " l " : " e ") << "\n");
       Visited.insert(*MI);
       ClusterIDMap[*MI] = CurrentClusterID;
-      CurrentClusterSize++;
     }
+    CurrentClusterSize += I.first;
     // Add this set size to the number of entries in this cluster.
     BalancinQueue.push(std::make_pair(CurrentClusterID, CurrentClusterSize));
   }
@@ -249,7 +276,7 @@ static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
 void llvm::SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals) {
+    bool PreserveLocals, bool BalanceByCodeSize) {
   if (!PreserveLocals) {
     for (Function &F : *M)
       externalize(&F);
@@ -264,7 +291,7 @@ void llvm::SplitModule(
   // This performs splitting without a need for externalization, which might not
   // always be possible.
   ClusterIDMapType ClusterIDMap;
-  findPartitions(M.get(), ClusterIDMap, N);
+  findPartitions(M.get(), ClusterIDMap, N, BalanceByCodeSize);
 
   // FIXME: We should be able to reuse M as the last partition instead of
   // cloning it.
@@ -0,0 +1,27 @@
+; RUN: llvm-as -bitcode-mdindex-threshold=0 < %s | llvm-dis -func=a | FileCheck %s
+; RUN: llvm-as < %s | llvm-dis -func=a | FileCheck %s
+; RUN: llvm-as < %s | not llvm-dis -func=missing 2>&1 | FileCheck --check-prefix=ERR %s
+
+; Only @a is materialized, and only the metadata it references is printed.
+
+; CHECK: define i32 @a() {
+; CHECK-NEXT: ret i32 0, !foo !0
+; CHECK: ; Materializable
+; CHECK-NEXT: define i32 @b() {}
+; CHECK: !0 = !{!"used by a", !1}
+; CHECK-NEXT: !1 = !{!"shared"}
+; CHECK-NOT: used by b
+
+; ERR: error: function 'missing' not found
+
+define i32 @a() {
+  ret i32 0, !foo !0
+}
+
+define i32 @b() {
+  ret i32 1, !foo !2
+}
+
+!0 = !{!"used by a", !1}
+!1 = !{!"shared"}
+!2 = !{!"used by b", !1}
@@ -0,0 +1,80 @@
+; Function blocks encoded on several threads must produce exactly the same
+; bitcode as the serial writer.
+; RUN: llvm-as < %s -o %t.serial.bc
+; RUN: llvm-as -bitcode-writer-threads=3 < %s -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+; RUN: llvm-as -preserve-bc-uselistorder < %s -o %t.serial.bc
+; RUN: llvm-as -preserve-bc-uselistorder -bitcode-writer-threads=3 < %s \
+; RUN:   -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+; RUN: llvm-dis < %t.parallel.bc | FileCheck %s
+
+; CHECK: define i32 @f0(i32 %x)
+; CHECK: define i32 @f1(i32 %x)
+; CHECK: define void @f2(i32 %x) !dbg
+; CHECK: define i8* @f3()
+; CHECK: define i32 @f4(i32 %a, i32 %b)
+
+@g = global i32 42
+@str = private constant [6 x i8] c"hello\00"
+
+declare void @llvm.dbg.value(metadata, metadata, metadata)
+
+define i32 @f0(i32 %x) {
+entry:
+  %v = load i32, i32* @g, !range !0
+  %sum = add i32 %x, %v
+  ret i32 %sum
+}
+
+define i32 @f1(i32 %x) {
+entry:
+  %cmp = icmp sgt i32 %x, 100
+  br i1 %cmp, label %big, label %small
+
+big:
+  %m = mul i32 %x, 3
+  ret i32 %m
+
+small:
+  %c = call i32 @f0(i32 %x)
+  ret i32 %c
+}
+
+define void @f2(i32 %x) !dbg !2 {
+  call void @llvm.dbg.value(metadata i32 %x, metadata !1, metadata !DIExpression()), !dbg !5
+  store i32 %x, i32* @g, !dbg !5
+  ret void, !dbg !5
+}
+
+define i8* @f3() {
+  ret i8* getelementptr ([6 x i8], [6 x i8]* @str, i32 0, i32 0)
+}
+
+define i32 @f4(i32 %a, i32 %b) {
+entry:
+  %t = add i32 %a, 7
+  %u = add i32 %b, 7
+  %w = xor i32 %t, %u
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %next, %loop ]
+  %next = add i32 %i, %w
+  %done = icmp ugt i32 %next, 1000
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %next
+}
+
+!llvm.dbg.cu = !{!3}
+!llvm.module.flags = !{!6}
+
+!0 = !{i32 0, i32 100}
+!1 = !DILocalVariable(name: "x", scope: !2)
+!2 = distinct !DISubprogram(name: "f2", scope: null, isDefinition: true, unit: !3)
+!3 = distinct !DICompileUnit(language: DW_LANG_C99, file: !4)
+!4 = !DIFile(filename: "t.c", directory: "/")
+!5 = !DILocation(line: 1, scope: !2)
+!6 = !{i32 2, !"Debug Info Version", i32 3}
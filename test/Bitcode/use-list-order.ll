@@ -1,4 +1,9 @@
 ; RUN: verify-uselistorder < %s
+; RUN: verify-uselistorder -bitcode-writer-threads=3 < %s
+; RUN: llvm-as -preserve-bc-uselistorder < %s -o %t.serial.bc
+; RUN: llvm-as -preserve-bc-uselistorder -bitcode-writer-threads=3 < %s \
+; RUN:   -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
 
 @a = global [4 x i1] [i1 0, i1 1, i1 0, i1 1]
 @b = alias i1, getelementptr ([4 x i1], [4 x i1]* @a, i64 0, i64 2)
@@ -0,0 +1,21 @@
+; Check that the GlobalISel passes are traced once per function.
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -time-trace \
+; RUN:   -time-trace-granularity=0 -time-trace-file=%t.json < %s -o /dev/null
+; RUN: grep -c '"name": "IRTranslator"' %t.json | FileCheck %s
+; RUN: grep -c '"name": "InstructionSelect"' %t.json | FileCheck %s
+; RUN: FileCheck %s --check-prefix=DETAIL < %t.json
+
+; CHECK: 2
+
+; DETAIL-DAG: "detail": "f"
+; DETAIL-DAG: "detail": "g"
+
+define i32 @f(i32 %x, i32 %y) {
+  %r = add i32 %x, %y
+  ret i32 %r
+}
+
+define i64 @g(i64 %x, i64 %y) {
+  %r = sub i64 %x, %y
+  ret i64 %r
+}
@@ -0,0 +1,43 @@
+; Check that instruction selection is traced once per function, not once per
+; basic block.
+; RUN: llc -mtriple=x86_64-- -time-trace -time-trace-granularity=0 \
+; RUN:   -time-trace-file=%t.json < %s -o /dev/null
+; RUN: grep -c '"name": "SelectionDAG"' %t.json | FileCheck %s
+; RUN: FileCheck %s --check-prefix=DETAIL < %t.json
+
+; The trace is written even if compilation fails.
+; RUN: echo "define void @h() {" | not llc -mtriple=x86_64-- -time-trace \
+; RUN:   -time-trace-file=%t.err.json -o /dev/null
+; RUN: FileCheck %s --check-prefix=ERR < %t.err.json
+
+; CHECK: 2
+
+; ERR: "traceEvents"
+
+; DETAIL-DAG: "detail": "f"
+; DETAIL-DAG: "detail": "g"
+
+define i32 @f(i1 %c, i32 %x) {
+entry:
+  br i1 %c, label %then, label %else
+then:
+  %a = add i32 %x, 1
+  br label %exit
+else:
+  %b = mul i32 %x, 3
+  br label %exit
+exit:
+  %r = phi i32 [ %a, %then ], [ %b, %else ]
+  ret i32 %r
+}
+
+define i32 @g(i32 %x) {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %zero, label %exit
+zero:
+  br label %exit
+exit:
+  %r = phi i32 [ 1, %zero ], [ %x, %entry ]
+  ret i32 %r
+}
@@ -0,0 +1,14 @@
+; RUN: lli -jit-kind=orc-lazy -jit-huge-pages %s
+;
+; Check that code can be run from memory requested with huge pages.
+
+define i32 @foo() {
+entry:
+  ret i32 0
+}
+
+define i32 @main(i32 %argc, i8** nocapture readnone %argv) {
+entry:
+  %0 = call i32() @foo()
+  ret i32 %0
+}
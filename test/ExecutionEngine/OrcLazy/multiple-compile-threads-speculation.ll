@@ -0,0 +1,44 @@
+; RUN: lli -jit-kind=orc-lazy -compile-threads=2 %s | FileCheck %s
+; REQUIRES: thread_support
+;
+; Multi-threaded instances compile the direct callees of each function ahead
+; of time, including callees that need to be promoted and callees that are
+; never called.
+;
+; CHECK: Hello from bar
+
+@.str = private unnamed_addr constant [16 x i8] c"Hello from bar\0A\00", align 1
+
+define internal void @bar() {
+entry:
+  %call = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([16 x i8], [16 x i8]* @.str, i32 0, i32 0))
+  ret void
+}
+
+define private void @foo() {
+entry:
+  call void @bar()
+  ret void
+}
+
+define void @unused() {
+entry:
+  call void @bar()
+  ret void
+}
+
+declare i32 @printf(i8*, ...)
+
+define i32 @main(i32 %argc, i8** %argv) {
+entry:
+  %cmp = icmp sgt i32 %argc, 100
+  br i1 %cmp, label %never, label %always
+
+never:
+  call void @unused()
+  br label %always
+
+always:
+  call void @foo()
+  ret i32 0
+}
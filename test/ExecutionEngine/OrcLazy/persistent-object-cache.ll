@@ -0,0 +1,20 @@
+; RUN: rm -rf %t.cache
+; RUN: lli -jit-kind=orc-lazy -enable-cache-manager -object-cache-dir=%t.cache %s
+; RUN: ls %t.cache | FileCheck %s
+; RUN: lli -jit-kind=orc-lazy -enable-cache-manager -object-cache-dir=%t.cache %s
+;
+; Check that compiled objects are stored in the cache directory, and that a
+; second run loads them back and still runs correctly.
+;
+; CHECK: llvmcache-{{[0-9A-F]+}}.o
+
+define i32 @foo() {
+entry:
+  ret i32 0
+}
+
+define i32 @main(i32 %argc, i8** nocapture readnone %argv) {
+entry:
+  %0 = call i32() @foo()
+  ret i32 %0
+}
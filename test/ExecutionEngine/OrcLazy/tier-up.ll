@@ -0,0 +1,71 @@
+; RUN: lli -jit-kind=orc-lazy -compile-threads=2 -tier-up-threshold=10 \
+; RUN:     -orc-lazy-debug=funcs-to-stdout %s | FileCheck %s
+; REQUIRES: thread_support
+;
+; Check that a function called more often than the threshold is recompiled,
+; that the program still computes the right result, and that calls made after
+; the recompiled body is ready reach it through the redirected stub.
+;
+; CHECK-DAG: add.tierup
+; CHECK-DAG: Sum: 4950
+; CHECK-DAG: {{^}}Redirected
+
+@.str = private unnamed_addr constant [9 x i8] c"Sum: %d\0A\00", align 1
+@.redirected = private unnamed_addr constant [12 x i8] c"Redirected\0A\00", align 1
+@.not.redirected = private unnamed_addr constant [16 x i8] c"Not redirected\0A\00", align 1
+
+define i32 @add(i32 %a, i32 %b) {
+entry:
+  %sum = add i32 %a, %b
+  ret i32 %sum
+}
+
+; Returns an address inside whichever body of @where is called, which differs
+; between the first tier and the recompiled copy.
+define i64 @where() {
+entry:
+  br label %here
+
+here:
+  ret i64 ptrtoint (i8* blockaddress(@where, %here) to i64)
+}
+
+declare i32 @printf(i8*, ...)
+declare i32 @usleep(i32)
+
+define i32 @main(i32 %argc, i8** %argv) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %loop ]
+  %sum.next = call i32 @add(i32 %sum, i32 %i)
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 100
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %call = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([9 x i8], [9 x i8]* @.str, i32 0, i32 0), i32 %sum.next)
+  %first = call i64 @where()
+  br label %wait
+
+; Keep calling @where, for up to ten seconds, until the call lands in the
+; recompiled body.
+wait:
+  %n = phi i32 [ 0, %exit ], [ %n.next, %wait.cont ]
+  %cur = call i64 @where()
+  %changed = icmp ne i64 %cur, %first
+  br i1 %changed, label %report, label %wait.cont
+
+wait.cont:
+  %slept = call i32 @usleep(i32 1000)
+  %n.next = add i32 %n, 1
+  %give.up = icmp eq i32 %n.next, 10000
+  br i1 %give.up, label %report, label %wait
+
+report:
+  %msg = select i1 %changed, i8* getelementptr inbounds ([12 x i8], [12 x i8]* @.redirected, i32 0, i32 0), i8* getelementptr inbounds ([16 x i8], [16 x i8]* @.not.redirected, i32 0, i32 0)
+  %call2 = call i32 (i8*, ...) @printf(i8* %msg)
+  ret i32 0
+}
@@ -0,0 +1,41 @@
+; Tests that the objects of the regular LTO codegen partitions are cached.
+; RUN: rm -rf %t.cache
+; RUN: llvm-as -o %t.bc %s
+; RUN: llvm-lto2 run -o %t.o %t.bc -lto-partitions=2 -cache-dir %t.cache \
+; RUN:   -r %t.bc,foo,px -r %t.bc,bar,px
+; RUN: ls %t.cache | count 0
+; RUN: llvm-lto2 run -o %t.o %t.bc -lto-partitions=2 -cache-dir %t.cache \
+; RUN:   -cache-lto-partitions -r %t.bc,foo,px -r %t.bc,bar,px
+; RUN: ls %t.cache | count 2
+
+; A second link is served from the cache and produces the same objects.
+; RUN: rm -f %t.o.0 %t.o.1
+; RUN: llvm-lto2 run -o %t.o %t.bc -lto-partitions=2 -cache-dir %t.cache \
+; RUN:   -cache-lto-partitions -r %t.bc,foo,px -r %t.bc,bar,px
+; RUN: ls %t.cache | count 2
+; RUN: llvm-nm %t.o.0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t.o.1 | FileCheck --check-prefix=CHECK1 %s
+
+; Different code generation options must not hit the same entries.
+; RUN: llvm-lto2 run -o %t.o %t.bc -lto-partitions=2 -cache-dir %t.cache \
+; RUN:   -cache-lto-partitions -cg-opt-level=1 -r %t.bc,foo,px -r %t.bc,bar,px
+; RUN: ls %t.cache | count 4
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; CHECK0-NOT: bar
+; CHECK0: T foo
+; CHECK0-NOT: bar
+define void @foo() {
+  call void @bar()
+  ret void
+}
+
+; CHECK1-NOT: foo
+; CHECK1: T bar
+; CHECK1-NOT: foo
+define void @bar() {
+  call void @foo()
+  ret void
+}
@@ -0,0 +1,45 @@
+; RUN: opt < %s -o /dev/null -instsimplify -stats-deltas=%t.json
+; RUN: FileCheck %s < %t.json
+; REQUIRES: asserts
+
+; Only the functions for which a statistic changed get an entry, followed by
+; the total of the module.
+
+; CHECK:      [
+; CHECK-NEXT:   {
+; CHECK-NEXT:     "function": "foo",
+; CHECK-NEXT:     "module": "<stdin>",
+; CHECK-NEXT:     "stats": {
+; CHECK-NEXT:       "instsimplify.NumSimplified": 2
+; CHECK-NEXT:     }
+; CHECK-NEXT:   },
+; CHECK-NEXT:   {
+; CHECK-NEXT:     "function": "baz",
+; CHECK-NEXT:     "module": "<stdin>",
+; CHECK-NEXT:     "stats": {
+; CHECK-NEXT:       "instsimplify.NumSimplified": 1
+; CHECK-NEXT:     }
+; CHECK-NEXT:   },
+; CHECK-NEXT:   {
+; CHECK-NEXT:     "module": "<stdin>",
+; CHECK-NEXT:     "stats": {
+; CHECK-NEXT:       "instsimplify.NumSimplified": 3
+; CHECK-NEXT:     }
+; CHECK-NEXT:   }
+; CHECK-NEXT: ]
+
+define i32 @foo() {
+  %a = add i32 5, 4
+  %b = mul i32 %a, 2
+  ret i32 %b
+}
+
+define i32 @bar(i32 %x) {
+  %a = add i32 %x, 4
+  ret i32 %a
+}
+
+define i32 @baz(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
@@ -0,0 +1,24 @@
+; Check that -time-trace produces a Chrome trace with per-function and
+; per-pass sections, for both pass managers.
+; RUN: opt -time-trace -time-trace-granularity=0 -time-trace-file=%t.json \
+; RUN:   -instcombine -disable-output < %s
+; RUN: FileCheck %s --check-prefix=LEGACY < %t.json
+; RUN: opt -time-trace -time-trace-granularity=0 -time-trace-file=%t.npm.json \
+; RUN:   -passes=instcombine -disable-output < %s
+; RUN: FileCheck %s --check-prefix=NEWPM < %t.npm.json
+
+; LEGACY: "traceEvents"
+; LEGACY-DAG: "name": "OptFunction"
+; LEGACY-DAG: "detail": "foo"
+; LEGACY-DAG: "name": "RunPass"
+; LEGACY-DAG: "detail": "Combine redundant instructions"
+; LEGACY-DAG: "name": "Total RunPass"
+
+; NEWPM: "traceEvents"
+; NEWPM-DAG: "name": "InstCombinePass"
+; NEWPM-DAG: "detail": "foo"
+
+define i32 @foo(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
@@ -0,0 +1,53 @@
+; Check that import lists are reused across links for modules whose imports
+; cannot have changed.
+; -stats requires asserts
+; REQUIRES: asserts
+
+; RUN: opt -module-summary -module-hash %s -o %t1.bc
+; RUN: opt -module-summary -module-hash %p/Inputs/import-cache1.ll -o %t2.bc
+; RUN: opt -module-summary -module-hash %p/Inputs/import-cache2.ll -o %t3.bc
+; RUN: rm -f %t.cache
+; RUN: llvm-lto2 run %t1.bc %t2.bc %t3.bc -o %t.o -thinlto-distributed-indexes \
+; RUN:   -thinlto-import-cache=%t.cache -stats \
+; RUN:   -r %t1.bc,main,plx -r %t1.bc,g, -r %t1.bc,h, \
+; RUN:   -r %t2.bc,g,pl -r %t3.bc,h,pl 2>&1 | FileCheck %s --check-prefix=FIRST
+; RUN: FileCheck %s --check-prefix=IMPORTS-BOTH < %t1.bc.imports
+
+; FIRST-NOT: import lists reused
+; IMPORTS-BOTH-DAG: import-cache.ll.tmp2.bc
+; IMPORTS-BOTH-DAG: import-cache.ll.tmp3.bc
+
+; Nothing changed, so all three lists are reused.
+; RUN: llvm-lto2 run %t1.bc %t2.bc %t3.bc -o %t.o -thinlto-distributed-indexes \
+; RUN:   -thinlto-import-cache=%t.cache -stats \
+; RUN:   -r %t1.bc,main,plx -r %t1.bc,g, -r %t1.bc,h, \
+; RUN:   -r %t2.bc,g,pl -r %t3.bc,h,pl 2>&1 | FileCheck %s --check-prefix=SECOND
+; RUN: FileCheck %s --check-prefix=IMPORTS-BOTH < %t1.bc.imports
+
+; SECOND: 3 function-import - Number of import lists reused
+
+; @h can no longer be imported. This module considered importing it and must
+; be recomputed, as must the changed module itself; the module defining @g
+; does not depend on either.
+; RUN: opt -module-summary -module-hash %p/Inputs/import-cache3.ll -o %t3.bc
+; RUN: llvm-lto2 run %t1.bc %t2.bc %t3.bc -o %t.o -thinlto-distributed-indexes \
+; RUN:   -thinlto-import-cache=%t.cache -stats \
+; RUN:   -r %t1.bc,main,plx -r %t1.bc,g, -r %t1.bc,h, \
+; RUN:   -r %t2.bc,g,pl -r %t3.bc,h,pl 2>&1 | FileCheck %s --check-prefix=THIRD
+; RUN: FileCheck %s --check-prefix=IMPORTS-G < %t1.bc.imports
+
+; THIRD: 1 function-import - Number of import lists reused
+; IMPORTS-G: import-cache.ll.tmp2.bc
+; IMPORTS-G-NOT: import-cache.ll.tmp3.bc
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare void @g()
+declare void @h()
+
+define i32 @main() {
+  call void @g()
+  call void @h()
+  ret i32 0
+}
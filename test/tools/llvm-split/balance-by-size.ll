@@ -0,0 +1,41 @@
+; RUN: llvm-split -balance-by-size -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; The large function gets a partition of its own, and all of the small
+; definitions are packed into the other one.
+
+; CHECK0: @g = external global i32
+; CHECK1: @g = global i32 0
+@g = global i32 0
+
+; CHECK0: define i32 @big(i32 %x)
+; CHECK1: declare i32 @big(i32)
+define i32 @big(i32 %x) {
+  %a = add i32 %x, 1
+  %b = add i32 %a, 2
+  %c = add i32 %b, 3
+  %d = add i32 %c, 4
+  %e = add i32 %d, 5
+  %f = add i32 %e, 6
+  %h = add i32 %f, 7
+  ret i32 %h
+}
+
+; CHECK0: declare void @s1()
+; CHECK1: define void @s1()
+define void @s1() {
+  ret void
+}
+
+; CHECK0: declare void @s2()
+; CHECK1: define void @s2()
+define void @s2() {
+  ret void
+}
+
+; CHECK0: declare void @s3()
+; CHECK1: define void @s3()
+define void @s3() {
+  ret void
+}
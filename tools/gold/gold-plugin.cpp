@@ -139,6 +139,10 @@ namespace options {
   static unsigned Parallelism = 0;
   // Default regular LTO codegen parallelism (number of partitions).
   static unsigned ParallelCodeGenParallelismLevel = 1;
+  // Balance the regular LTO codegen partitions by instruction count.
+  static bool BalanceCodeGenPartitions = false;
+  // Cache the regular LTO codegen partitions in cache_dir.
+  static bool CacheCodeGenPartitions = false;
 #ifdef NDEBUG
   static bool DisableVerify = true;
 #else
@@ -188,6 +192,8 @@ namespace options {
   static std::string thinlto_object_suffix_replace;
   // Optional path to a directory for caching ThinLTO objects.
   static std::string cache_dir;
+  // File in which to cache the ThinLTO import lists across links.
+  static std::string thinlto_import_cache;
   // Optional pruning policy for ThinLTO caches.
   static std::string cache_policy;
   // Additional options to pass into the code generator.
@@ -254,6 +260,8 @@ namespace options {
       cache_dir = opt.substr(strlen("cache-dir="));
     } else if (opt.startswith("cache-policy=")) {
       cache_policy = opt.substr(strlen("cache-policy="));
+    } else if (opt.startswith("thinlto-import-cache=")) {
+      thinlto_import_cache = opt.substr(strlen("thinlto-import-cache="));
     } else if (opt.size() == 2 && opt[0] == 'O') {
       if (opt[1] < '0' || opt[1] > '3')
         message(LDPL_FATAL, "Optimization level must be between 0 and 3");
@@ -265,6 +273,10 @@ namespace options {
       if (opt.substr(strlen("lto-partitions="))
               .getAsInteger(10, ParallelCodeGenParallelismLevel))
         message(LDPL_FATAL, "Invalid codegen partition level: %s", opt_ + 5);
+    } else if (opt == "lto-balance-partitions") {
+      BalanceCodeGenPartitions = true;
+    } else if (opt == "lto-cache-partitions") {
+      CacheCodeGenPartitions = true;
     } else if (opt == "disable-verify") {
       DisableVerify = true;
     } else if (opt.startswith("sample-profile=")) {
@@ -845,6 +857,9 @@ static std::unique_ptr<LTO> createLTO(IndexWriteCallback OnIndexWrite,
   Conf.CodeModel = getCodeModel();
   Conf.CGOptLevel = getCGOptLevel();
   Conf.DisableVerify = options::DisableVerify;
+  Conf.BalanceCodeGenPartitions = options::BalanceCodeGenPartitions;
+  Conf.CacheCodeGenPartitions = options::CacheCodeGenPartitions;
+  Conf.ThinLTOImportCachePath = options::thinlto_import_cache;
   Conf.OptLevel = options::OptLevel;
   if (options::Parallelism)
     Backend = createInProcessThinBackend(options::Parallelism);
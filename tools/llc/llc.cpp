@@ -37,6 +37,7 @@
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Host.h"
@@ -46,6 +47,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Target/TargetMachine.h"
@@ -147,6 +149,21 @@ static cl::opt<std::string>
                     cl::desc("YAML output filename for pass remarks"),
                     cl::value_desc("filename"));
 
+static cl::opt<bool> TimeTrace(
+    "time-trace",
+    cl::desc("Record time trace of the compilation in Chrome trace format"));
+
+static cl::opt<unsigned> TimeTraceGranularity(
+    "time-trace-granularity",
+    cl::desc(
+        "Minimum time granularity (in microseconds) traced by time profiler"),
+    cl::init(500));
+
+static cl::opt<std::string>
+    TimeTraceFile("time-trace-file",
+                  cl::desc("Specify time trace file destination"),
+                  cl::value_desc("filename"));
+
 namespace {
 static ManagedStatic<std::vector<std::string>> RunPassNames;
 
@@ -171,9 +188,7 @@ static cl::opt<RunPassOption, true, cl::parser<std::string>> RunPass(
 
 static int compileModule(char **, LLVMContext &);
 
-static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
-                                                       Triple::OSType OS,
-                                                       const char *ProgName) {
+static void ComputeOutputFilename(const char *TargetName, Triple::OSType OS) {
   // If we don't yet have an output filename, make one.
   if (OutputFilename.empty()) {
     if (InputFilename == "-")
@@ -212,6 +227,12 @@ static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
       }
     }
   }
+}
+
+static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
+                                                       Triple::OSType OS,
+                                                       const char *ProgName) {
+  ComputeOutputFilename(TargetName, OS);
 
   // Decide if we need "binary" output.
   bool Binary = false;
@@ -297,11 +318,14 @@ int main(int argc, char **argv) {
   initializePostInlineEntryExitInstrumenterPass(*Registry);
   initializeUnreachableBlockElimLegacyPassPass(*Registry);
   initializeConstantHoistingLegacyPassPass(*Registry);
-  initializeScalarOpts(*Registry);
-  initializeVectorization(*Registry);
   initializeScalarizeMaskedMemIntrinPass(*Registry);
   initializeExpandReductionsPass(*Registry);
 
+  // Most of the optimization passes are never run by llc; register them only
+  // if one is named on the command line or required by another pass.
+  Registry->registerLazyInitializer(initializeScalarOpts);
+  Registry->registerLazyInitializer(initializeVectorization);
+
   // Initialize debugging passes.
   initializeScavengerTestPass(*Registry);
 
@@ -344,11 +368,28 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (TimeTrace)
+    timeTraceProfilerInitialize(TimeTraceGranularity);
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
-  for (unsigned I = TimeCompilations; I; --I)
-    if (int RetVal = compileModule(argv, Context))
-      return RetVal;
+  int RetVal = 0;
+  for (unsigned I = TimeCompilations; I && !RetVal; --I)
+    RetVal = compileModule(argv, Context);
+
+  // Write the trace even if compilation failed, it shows how far it got.
+  if (TimeTrace) {
+    if (!timeTraceProfilerWrite(TimeTraceFile, OutputFilename.empty()
+                                                   ? InputFilename
+                                                   : OutputFilename)) {
+      WithColor::error(errs(), argv[0]) << "could not write time trace file\n";
+      RetVal = 1;
+    }
+    timeTraceProfilerCleanup();
+  }
+
+  if (RetVal)
+    return RetVal;
 
   if (YamlFile)
     YamlFile->keep();
@@ -466,10 +507,26 @@ static int compileModule(char **argv, LLVMContext &Context) {
   if (FloatABIForCalls != FloatABI::Default)
     Options.FloatABIType = FloatABIForCalls;
 
-  // Figure out where we are going to send the output.
-  std::unique_ptr<ToolOutputFile> Out =
-      GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]);
-  if (!Out) return 1;
+  // Figure out where we are going to send the output. Object files are
+  // written straight into a mapping of the output file, unless they have to
+  // be compared in memory for -compile-twice.
+  std::unique_ptr<ToolOutputFile> Out;
+  std::unique_ptr<raw_mapped_file_ostream> MappedOut;
+  ComputeOutputFilename(TheTarget->getName(), TheTriple.getOS());
+  if (FileType == TargetMachine::CGFT_ObjectFile && !CompileTwice &&
+      OutputFilename != "-") {
+    Expected<std::unique_ptr<raw_mapped_file_ostream>> MappedOrErr =
+        raw_mapped_file_ostream::create(OutputFilename);
+    if (!MappedOrErr) {
+      WithColor::error(errs(), argv[0])
+          << toString(MappedOrErr.takeError()) << '\n';
+      return 1;
+    }
+    MappedOut = std::move(*MappedOrErr);
+  } else {
+    Out = GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]);
+    if (!Out) return 1;
+  }
 
   std::unique_ptr<ToolOutputFile> DwoOut;
   if (!SplitDwarfOutputFile.empty()) {
@@ -519,15 +576,17 @@ static int compileModule(char **argv, LLVMContext &Context) {
         << ": warning: ignoring -mc-relax-all because filetype != obj";
 
   {
-    raw_pwrite_stream *OS = &Out->os();
+    raw_pwrite_stream *OS = MappedOut.get();
+    if (!MappedOut)
+      OS = &Out->os();
 
     // Manually do the buffering rather than using buffer_ostream,
     // so we can memcmp the contents in CompileTwice mode
     SmallVector<char, 0> Buffer;
     std::unique_ptr<raw_svector_ostream> BOS;
-    if ((FileType != TargetMachine::CGFT_AssemblyFile &&
-         !Out->os().supportsSeeking()) ||
-        CompileTwice) {
+    if (!MappedOut && ((FileType != TargetMachine::CGFT_AssemblyFile &&
+                        !Out->os().supportsSeeking()) ||
+                       CompileTwice)) {
       BOS = make_unique<raw_svector_ostream>(Buffer);
       OS = BOS.get();
     }
@@ -622,7 +681,14 @@ static int compileModule(char **argv, LLVMContext &Context) {
   }
 
   // Declare success.
-  Out->keep();
+  if (MappedOut) {
+    if (llvm::Error E = MappedOut->commit()) {
+      WithColor::error(errs(), argv[0]) << toString(std::move(E)) << '\n';
+      return 1;
+    }
+  } else {
+    Out->keep();
+  }
   if (DwoOut)
     DwoOut->keep();
 
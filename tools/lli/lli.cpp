@@ -28,6 +28,7 @@
 #include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/ExecutionEngine/Orc/OrcRemoteTargetClient.h"
+#include "llvm/ExecutionEngine/Orc/PersistentObjectCache.h"
 #include "llvm/ExecutionEngine/OrcMCJITReplacement.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/IR/IRBuilder.h"
@@ -113,6 +114,19 @@ namespace {
                "rather than individual functions"),
       cl::init(false));
 
+  cl::opt<unsigned> TierUpThreshold(
+      "tier-up-threshold",
+      cl::desc("Recompile functions with full codegen optimization once "
+               "they have been called this many times (jit-kind=orc-lazy "
+               "with -compile-threads only)"),
+      cl::init(0));
+
+  cl::opt<bool> JITHugePages(
+      "jit-huge-pages",
+      cl::desc("Back JIT'd code with huge pages where supported "
+               "(jit-kind=orc-lazy only)"),
+      cl::init(false));
+
   cl::list<std::string>
       JITDylibs("jd",
                 cl::desc("Specifies the JITDylib to be used for any subsequent "
@@ -781,24 +795,43 @@ int runOrcLazyJIT(const char *ProgName) {
 
   DataLayout DL = ExitOnErr(JTMB.getDefaultDataLayoutForTarget());
 
+  std::unique_ptr<orc::PersistentObjectCache> ObjCache;
+  if (EnableCacheManager) {
+    if (ObjectCacheDir.empty()) {
+      errs() << "-enable-cache-manager requires -object-cache-dir with "
+                "-jit-kind=orc-lazy\n";
+      exit(1);
+    }
+    ObjCache =
+        ExitOnErr(orc::PersistentObjectCache::Create(ObjectCacheDir, JTMB));
+  }
+
   auto J = ExitOnErr(orc::LLLazyJIT::Create(
       std::move(JTMB), DL,
       pointerToJITTargetAddress(exitOnLazyCallThroughFailure),
       LazyJITCompileThreads));
 
+  if (ObjCache)
+    J->setObjectCache(ObjCache.get());
+  if (JITHugePages)
+    J->getMemoryMapper().setHugePagesForCode(true);
+
   if (PerModuleLazy)
     J->setPartitionFunction(orc::CompileOnDemandLayer::compileWholeModule);
 
   auto Dump = createDebugDumper();
 
-  J->setLazyCompileTransform([&](orc::ThreadSafeModule TSM,
-                                 const orc::MaterializationResponsibility &R) {
+  auto Transform = [&](orc::ThreadSafeModule TSM,
+                       const orc::MaterializationResponsibility &R) {
     if (verifyModule(*TSM.getModule(), &dbgs())) {
       dbgs() << "Bad module: " << *TSM.getModule() << "\n";
       exit(1);
     }
     return Dump(std::move(TSM), R);
-  });
+  };
+  J->setLazyCompileTransform(Transform);
+  if (TierUpThreshold)
+    ExitOnErr(J->enableTieredCompilation(TierUpThreshold, Transform));
   J->getMainJITDylib().setGenerator(
       ExitOnErr(orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(DL)));
 
@@ -901,6 +934,16 @@ void disallowOrcOptions() {
     exit(1);
   }
 
+  if (TierUpThreshold) {
+    errs() << "-tier-up-threshold requires -jit-kind=orc-lazy\n";
+    exit(1);
+  }
+
+  if (JITHugePages) {
+    errs() << "-jit-huge-pages requires -jit-kind=orc-lazy\n";
+    exit(1);
+  }
+
   if (PerModuleLazy) {
     errs() << "-per-module-lazy requires -jit-kind=orc-lazy\n";
     exit(1);
@@ -67,6 +67,12 @@ static cl::opt<bool>
                         cl::desc("Load module without materializing metadata, "
                                  "then materialize only the metadata"));
 
+static cl::list<std::string>
+    OnlyFunctions("func",
+                  cl::desc("Only materialize the specified function(s), "
+                           "reading only the parts of the bitcode they need"),
+                  cl::ZeroOrMore, cl::value_desc("function"));
+
 namespace {
 
 static void printDebugLoc(const DebugLoc &DL, formatted_raw_ostream &OS) {
@@ -158,12 +164,25 @@ int main(int argc, char **argv) {
 
   std::unique_ptr<MemoryBuffer> MB =
       ExitOnErr(errorOrToExpected(MemoryBuffer::getFileOrSTDIN(InputFilename)));
+  // When only some functions are printed, load the module-level metadata
+  // through its index, so that only the nodes those functions use are read.
   std::unique_ptr<Module> M = ExitOnErr(getLazyBitcodeModule(
-      *MB, Context, /*ShouldLazyLoadMetadata=*/true, SetImporting));
-  if (MaterializeMetadata)
+      *MB, Context, /*ShouldLazyLoadMetadata=*/true, SetImporting,
+      /*LoadMetadataOnDemand=*/!OnlyFunctions.empty()));
+  if (MaterializeMetadata) {
+    ExitOnErr(M->materializeMetadata());
+  } else if (!OnlyFunctions.empty()) {
+    for (const std::string &Name : OnlyFunctions) {
+      Function *F = M->getFunction(Name);
+      if (!F)
+        ExitOnErr(createStringError(inconvertibleErrorCode(),
+                                    "function '%s' not found", Name.c_str()));
+      ExitOnErr(F->materialize());
+    }
     ExitOnErr(M->materializeMetadata());
-  else
+  } else {
     ExitOnErr(M->materializeAll());
+  }
 
   BitcodeLTOInfo LTOInfo = ExitOnErr(getBitcodeLTOInfo(*MB));
   std::unique_ptr<ModuleSummaryIndex> Index;
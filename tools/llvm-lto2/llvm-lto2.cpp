@@ -25,6 +25,7 @@
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
 
 using namespace llvm;
 using namespace lto;
@@ -68,6 +69,20 @@ static cl::opt<bool>
 static cl::opt<int> Threads("thinlto-threads",
                             cl::init(llvm::heavyweight_hardware_concurrency()));
 
+static cl::opt<std::string> ImportCache(
+    "thinlto-import-cache",
+    cl::desc("File in which to cache the ThinLTO import lists across links"));
+
+static cl::opt<unsigned>
+    Partitions("lto-partitions", cl::init(1),
+               cl::desc("Number of partitions the regular LTO module is split "
+                        "into for parallel code generation"));
+
+static cl::opt<bool> CachePartitions(
+    "cache-lto-partitions", cl::init(false),
+    cl::desc("Cache the object files of the regular LTO codegen partitions "
+             "in the directory given by -cache-dir"));
+
 static cl::list<std::string> SymbolResolutions(
     "r",
     cl::desc("Specify a symbol resolution: filename,symbolname,resolution\n"
@@ -116,12 +131,41 @@ static cl::opt<bool>
 static cl::opt<std::string>
     StatsFile("stats-file", cl::desc("Filename to write statistics to"));
 
+static cl::opt<bool>
+    TimeTrace("time-trace",
+              cl::desc("Record time trace of the LTO pipeline in Chrome "
+                       "trace format"));
+
+static cl::opt<unsigned> TimeTraceGranularity(
+    "time-trace-granularity",
+    cl::desc(
+        "Minimum time granularity (in microseconds) traced by time profiler"),
+    cl::init(500));
+
+static cl::opt<std::string>
+    TimeTraceFile("time-trace-file",
+                  cl::desc("Specify time trace file destination"),
+                  cl::value_desc("filename"));
+
+/// Write the time trace, if one is being recorded. Called on the paths that
+/// exit with an error too, so that a failed link still shows how far it got.
+static bool writeTimeTrace() {
+  if (!timeTraceProfilerEnabled())
+    return true;
+  bool Written = timeTraceProfilerWrite(TimeTraceFile, OutputFilename);
+  if (!Written)
+    errs() << "llvm-lto2: could not write time trace file\n";
+  timeTraceProfilerCleanup();
+  return Written;
+}
+
 static void check(Error E, std::string Msg) {
   if (!E)
     return;
   handleAllErrors(std::move(E), [&](ErrorInfoBase &EIB) {
     errs() << "llvm-lto2: " << Msg << ": " << EIB.message().c_str() << '\n';
   });
+  writeTimeTrace();
   exit(1);
 }
 
@@ -192,8 +236,10 @@ static int run(int argc, char **argv) {
     DiagnosticPrinterRawOStream DP(errs());
     DI.print(DP);
     errs() << '\n';
-    if (DI.getSeverity() == DS_Error)
+    if (DI.getSeverity() == DS_Error) {
+      writeTimeTrace();
       exit(1);
+    }
   };
 
   Conf.CPU = MCPU;
@@ -245,6 +291,8 @@ static int run(int argc, char **argv) {
   Conf.OverrideTriple = OverrideTriple;
   Conf.DefaultTriple = DefaultTriple;
   Conf.StatsFile = StatsFile;
+  Conf.CacheCodeGenPartitions = CachePartitions;
+  Conf.ThinLTOImportCachePath = ImportCache;
 
   ThinBackend Backend;
   if (ThinLTODistributedIndexes)
@@ -255,7 +303,7 @@ static int run(int argc, char **argv) {
                                             /* OnWrite */ {});
   else
     Backend = createInProcessThinBackend(Threads);
-  LTO Lto(std::move(Conf), std::move(Backend));
+  LTO Lto(std::move(Conf), std::move(Backend), Partitions);
 
   bool HasErrors = false;
   for (std::string F : InputFilenames) {
@@ -298,11 +346,7 @@ static int run(int argc, char **argv) {
   auto AddStream =
       [&](size_t Task) -> std::unique_ptr<lto::NativeObjectStream> {
     std::string Path = OutputFilename + "." + utostr(Task);
-
-    std::error_code EC;
-    auto S = llvm::make_unique<raw_fd_ostream>(Path, EC, sys::fs::F_None);
-    check(EC, Path);
-    return llvm::make_unique<lto::NativeObjectStream>(std::move(S));
+    return check(lto::createNativeObjectFileStream(Path), Path);
   };
 
   auto AddBuffer = [&](size_t Task, std::unique_ptr<MemoryBuffer> MB) {
@@ -313,7 +357,13 @@ static int run(int argc, char **argv) {
   if (!CacheDir.empty())
     Cache = check(localCache(CacheDir, AddBuffer), "failed to create cache");
 
+  if (TimeTrace)
+    timeTraceProfilerInitialize(TimeTraceGranularity);
+
   check(Lto.run(AddStream, Cache), "LTO::run failed");
+
+  if (!writeTimeTrace())
+    return 1;
   return 0;
 }
 
@@ -267,7 +267,7 @@ CompressedSection::CompressedSection(const SectionBase &Sec,
     return;
   }
 
-  if (Error E = zlib::compress(
+  if (Error E = zlib::compressParallel(
           StringRef(reinterpret_cast<const char *>(OriginalData.data()),
                     OriginalData.size()),
           CompressedData))
@@ -139,6 +139,11 @@ static cl::opt<unsigned long long>
     ClAdjustVMA("adjust-vma", cl::init(0), cl::value_desc("offset"),
                 cl::desc("Add specified offset to object file addresses"));
 
+static cl::opt<bool>
+    ClBatch("batch", cl::init(false),
+            cl::desc("Read all input addresses before printing any, and "
+                     "symbolize them together"));
+
 static cl::list<std::string> ClInputAddresses(cl::Positional,
                                               cl::desc("<input addresses>..."),
                                               cl::ZeroOrMore);
@@ -190,6 +195,15 @@ static bool parseCommand(StringRef InputString, bool &IsData,
   return !StringRef(pos, offset_length).getAsInteger(0, ModuleOffset);
 }
 
+static void printAddress(uint64_t ModuleOffset) {
+  if (ClPrintAddress) {
+    outs() << "0x";
+    outs().write_hex(ModuleOffset);
+    StringRef Delimiter = ClPrettyPrint ? ": " : "\n";
+    outs() << Delimiter;
+  }
+}
+
 static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
                            DIPrinter &Printer) {
   bool IsData = false;
@@ -200,12 +214,7 @@ static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
     return;
   }
 
-  if (ClPrintAddress) {
-    outs() << "0x";
-    outs().write_hex(ModuleOffset);
-    StringRef Delimiter = ClPrettyPrint ? ": " : "\n";
-    outs() << Delimiter;
-  }
+  printAddress(ModuleOffset);
   ModuleOffset -= ClAdjustVMA;
   if (IsData) {
     auto ResOrErr = Symbolizer.symbolizeData(ModuleName, ModuleOffset);
@@ -223,6 +232,59 @@ static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
   outs().flush();
 }
 
+// Like symbolizeInput for each of Inputs, with the code addresses resolved
+// in one batch.
+static void symbolizeInputs(ArrayRef<std::string> Inputs,
+                            LLVMSymbolizer &Symbolizer, DIPrinter &Printer) {
+  struct Command {
+    bool Parsed;
+    bool IsData;
+    std::string ModuleName;
+    uint64_t ModuleOffset;
+  };
+  std::vector<Command> Commands(Inputs.size());
+  std::vector<LLVMSymbolizer::ModuleAddress> Code;
+  for (size_t I = 0, E = Inputs.size(); I != E; ++I) {
+    Command &C = Commands[I];
+    C.Parsed = parseCommand(Inputs[I], C.IsData, C.ModuleName, C.ModuleOffset);
+    if (C.Parsed && !C.IsData)
+      Code.push_back({C.ModuleName, C.ModuleOffset - ClAdjustVMA});
+  }
+
+  auto HandleLoadError = [](Error Err) {
+    logAllUnhandledErrors(std::move(Err), errs(),
+                          "LLVMSymbolizer: error reading file: ");
+  };
+  std::vector<DIInliningInfo> InlinedCode;
+  std::vector<DILineInfo> LineInfos;
+  if (ClPrintInlining)
+    InlinedCode =
+        Symbolizer.symbolizeInlinedCodeBatch(Code, HandleLoadError, ClDwpName);
+  else
+    LineInfos = Symbolizer.symbolizeCodeBatch(Code, HandleLoadError, ClDwpName);
+
+  size_t NextCode = 0;
+  for (size_t I = 0, E = Inputs.size(); I != E; ++I) {
+    Command &C = Commands[I];
+    if (!C.Parsed) {
+      outs() << Inputs[I];
+      continue;
+    }
+    printAddress(C.ModuleOffset);
+    if (C.IsData) {
+      auto ResOrErr =
+          Symbolizer.symbolizeData(C.ModuleName, C.ModuleOffset - ClAdjustVMA);
+      Printer << (error(ResOrErr) ? DIGlobal() : ResOrErr.get());
+    } else if (ClPrintInlining) {
+      Printer << InlinedCode[NextCode++];
+    } else {
+      Printer << LineInfos[NextCode++];
+    }
+    outs() << "\n";
+  }
+  outs().flush();
+}
+
 int main(int argc, char **argv) {
   InitLLVM X(argc, argv);
 
@@ -250,7 +312,18 @@ int main(int argc, char **argv) {
                     ClPrettyPrint, ClPrintSourceContextLines, ClVerbose,
                     ClBasenames);
 
-  if (ClInputAddresses.empty()) {
+  if (ClBatch) {
+    std::vector<std::string> Inputs(ClInputAddresses.begin(),
+                                    ClInputAddresses.end());
+    if (Inputs.empty()) {
+      const int kMaxInputStringLength = 1024;
+      char InputString[kMaxInputStringLength];
+
+      while (fgets(InputString, sizeof(InputString), stdin))
+        Inputs.push_back(InputString);
+    }
+    symbolizeInputs(Inputs, Symbolizer, Printer);
+  } else if (ClInputAddresses.empty()) {
     const int kMaxInputStringLength = 1024;
     char InputString[kMaxInputStringLength];
 
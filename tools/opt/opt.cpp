@@ -48,6 +48,7 @@
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Target/TargetMachine.h"
@@ -274,6 +275,21 @@ static cl::opt<std::string>
                     cl::desc("YAML output filename for pass remarks"),
                     cl::value_desc("filename"));
 
+static cl::opt<bool> TimeTrace(
+    "time-trace",
+    cl::desc("Record time trace of the optimization in Chrome trace format"));
+
+static cl::opt<unsigned> TimeTraceGranularity(
+    "time-trace-granularity",
+    cl::desc(
+        "Minimum time granularity (in microseconds) traced by time profiler"),
+    cl::init(500));
+
+static cl::opt<std::string>
+    TimeTraceFile("time-trace-file",
+                  cl::desc("Specify time trace file destination"),
+                  cl::value_desc("filename"));
+
 cl::opt<PGOKind>
     PGOKindFlag("pgo-kind", cl::init(NoPGO), cl::Hidden,
                 cl::desc("The kind of profile guided optimization"),
@@ -444,6 +460,28 @@ static TargetMachine* GetTargetMachine(Triple TheTriple, StringRef CPUStr,
                                         getCodeModel(), GetCodeGenOptLevel());
 }
 
+namespace {
+/// Initializes the time-trace profiler if -time-trace was given, and writes
+/// the collected trace when main() returns, whichever pipeline was run.
+struct TimeTracerRAII {
+  const char *Argv0;
+
+  TimeTracerRAII(const char *Argv0) : Argv0(Argv0) {
+    if (TimeTrace)
+      timeTraceProfilerInitialize(TimeTraceGranularity);
+  }
+  ~TimeTracerRAII() {
+    if (!TimeTrace)
+      return;
+    if (!timeTraceProfilerWrite(TimeTraceFile, OutputFilename.empty()
+                                                   ? InputFilename
+                                                   : OutputFilename))
+      errs() << Argv0 << ": could not write time trace file\n";
+    timeTraceProfilerCleanup();
+  }
+};
+} // end anonymous namespace
+
 #ifdef LINK_POLLY_INTO_TOOLS
 namespace polly {
 void initializePollyPasses(llvm::PassRegistry &Registry);
@@ -510,6 +548,8 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv,
     "llvm .bc -> .bc modular optimizer and analysis printer\n");
 
+  TimeTracerRAII TimeTracer(argv[0]);
+
   if (AnalyzeOnly && NoOutput) {
     errs() << argv[0] << ": analyze mode conflicts with no-output mode.\n";
     return 1;
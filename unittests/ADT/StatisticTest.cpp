@@ -9,6 +9,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <thread>
 using namespace llvm;
 
 using OptionalStatistic = Optional<std::pair<StringRef, unsigned>>;
@@ -56,6 +57,38 @@ TEST(StatisticTest, Assign) {
 #endif
 }
 
+#if LLVM_ENABLE_THREADS
+TEST(StatisticTest, Threads) {
+  EnableStatistics();
+
+  // The increments of each thread go to its own shard, and are summed up
+  // when the value is read.
+  Counter = 0;
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I < 40; ++I)
+    Threads.emplace_back([] {
+      for (unsigned J = 0; J < 1000; ++J)
+        ++Counter;
+      Counter += 2;
+    });
+  for (std::thread &T : Threads)
+    T.join();
+#if LLVM_ENABLE_STATS
+  EXPECT_EQ(Counter, 40u * 1002u);
+#else
+  EXPECT_EQ(Counter, 0u);
+#endif
+
+  // Assigning a value discards the counts of all threads.
+  Counter = 3;
+#if LLVM_ENABLE_STATS
+  EXPECT_EQ(Counter, 3u);
+#else
+  EXPECT_EQ(Counter, 0u);
+#endif
+}
+#endif
+
 TEST(StatisticTest, API) {
   EnableStatistics();
 
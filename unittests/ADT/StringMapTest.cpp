@@ -531,4 +531,21 @@ TEST(StringMapCustomTest, StringMapEntrySize) {
   EXPECT_EQ(LargeValue, Key.size());
 }
 
+// Lookups with a precomputed hash see the same entries as plain lookups.
+TEST(StringMapCustomTest, PrecomputedHash) {
+  StringMap<int> Map;
+  StringRef Key = "key";
+  unsigned Hash = StringMapImpl::hash(Key);
+  auto Result = Map.try_emplace_with_hash(Key, Hash, 1);
+  EXPECT_TRUE(Result.second);
+  EXPECT_FALSE(Map.try_emplace_with_hash(Key, Hash, 2).second);
+  EXPECT_EQ(Result.first, Map.find(Key, Hash));
+  EXPECT_EQ(1, Map.lookup(Key));
+
+  const StringMap<int> &ConstMap = Map;
+  EXPECT_EQ(ConstMap.end(),
+            ConstMap.find("other", StringMapImpl::hash("other")));
+  EXPECT_EQ(1, ConstMap.find(Key, Hash)->second);
+}
+
 } // end anonymous namespace
@@ -139,6 +139,47 @@ TEST(BitstreamReaderTest, readRecordWithBlobWhileStreaming) {
   }
 }
 
+TEST(BitstreamReaderTest, readVBRArrays) {
+  // Mostly values that fit in one chunk, with some that do not.
+  SmallVector<uint64_t, 64> Values;
+  for (uint64_t I = 0; I != 200; ++I)
+    Values.push_back(I % 23 == 3 ? I << (I % 40) : I % 32);
+
+  const unsigned BlockID = bitc::FIRST_APPLICATION_BLOCKID;
+  const unsigned RecordID = 1;
+  SmallVector<char, 1> Buffer;
+  unsigned AbbrevID;
+  {
+    BitstreamWriter Stream(Buffer);
+    Stream.EnterSubblock(BlockID, 3);
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(RecordID));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 5));
+    AbbrevID = Stream.EmitAbbrev(std::move(Abbrev));
+    Stream.EmitRecord(RecordID, Values, AbbrevID);
+    Stream.EmitRecord(RecordID, Values);
+    Stream.ExitBlock();
+  }
+
+  BitstreamCursor Stream(
+      ArrayRef<uint8_t>((const uint8_t *)Buffer.begin(), Buffer.size()));
+  BitstreamEntry Entry =
+      Stream.advance(BitstreamCursor::AF_DontAutoprocessAbbrevs);
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+
+  // Abbreviated, then unabbreviated.
+  for (unsigned ID : {AbbrevID, unsigned(bitc::UNABBREV_RECORD)}) {
+    Entry = Stream.advance();
+    ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+    ASSERT_EQ(ID, Entry.ID);
+    SmallVector<uint64_t, 1> Record;
+    ASSERT_EQ(RecordID, Stream.readRecord(Entry.ID, Record));
+    EXPECT_EQ(Values, Record);
+  }
+}
+
 TEST(BitstreamReaderTest, shortRead) {
   uint8_t Bytes[] = {8, 7, 6, 5, 4, 3, 2, 1};
   for (unsigned I = 1; I != 8; ++I) {
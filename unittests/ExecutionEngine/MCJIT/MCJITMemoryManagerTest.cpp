@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Support/Process.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -165,5 +166,141 @@ TEST(MCJITMemoryManagerTest, ManyVariedAllocations) {
   }
 }
 
+TEST(MCJITMemoryManagerTest, PooledAllocations) {
+  PooledMemoryMapper Mapper(0x100000);
+
+  for (bool HugePages : {false, true}) {
+    Mapper.setHugePagesForCode(HugePages);
+    std::unique_ptr<SectionMemoryManager> MemMgr(
+        new SectionMemoryManager(&Mapper));
+
+    uint8_t *code1 = MemMgr->allocateCodeSection(256, 0, 1, "");
+    uint8_t *data1 = MemMgr->allocateDataSection(256, 0, 2, "", true);
+    uint8_t *code2 = MemMgr->allocateCodeSection(0x200000, 0, 3, "");
+    uint8_t *data2 = MemMgr->allocateDataSection(256, 0, 4, "", false);
+
+    EXPECT_NE((uint8_t*)nullptr, code1);
+    EXPECT_NE((uint8_t*)nullptr, code2);
+    EXPECT_NE((uint8_t*)nullptr, data1);
+    EXPECT_NE((uint8_t*)nullptr, data2);
+
+    for (unsigned i = 0; i < 256; ++i) {
+      code1[i] = 1;
+      code2[i] = 2;
+      data1[i] = 3;
+      data2[i] = 4;
+    }
+    for (unsigned i = 0; i < 256; ++i) {
+      EXPECT_EQ(1, code1[i]);
+      EXPECT_EQ(2, code2[i]);
+      EXPECT_EQ(3, data1[i]);
+      EXPECT_EQ(4, data2[i]);
+    }
+
+    std::string Error;
+    EXPECT_FALSE(MemMgr->finalizeMemory(&Error));
+    EXPECT_EQ(1, code1[0]);
+    EXPECT_EQ(3, data1[0]);
+  }
+}
+
+TEST(MCJITMemoryManagerTest, PooledMemoryIsRecycled) {
+  PooledMemoryMapper Mapper(0x100000);
+
+  uint8_t *FirstCode = nullptr;
+  size_t Reserved = 0;
+  for (unsigned Round = 0; Round < 3; ++Round) {
+    std::unique_ptr<SectionMemoryManager> MemMgr(
+        new SectionMemoryManager(&Mapper));
+    uint8_t *code = MemMgr->allocateCodeSection(4096, 0, 1, "");
+    uint8_t *data = MemMgr->allocateDataSection(4096, 0, 2, "", false);
+    ASSERT_NE((uint8_t*)nullptr, code);
+    ASSERT_NE((uint8_t*)nullptr, data);
+    // Memory that was executable in the previous round must be writable.
+    code[0] = 1;
+    data[0] = 2;
+    std::string Error;
+    EXPECT_FALSE(MemMgr->finalizeMemory(&Error));
+
+    if (Round == 0) {
+      FirstCode = code;
+      Reserved = Mapper.getReservedSize();
+    } else {
+      // The blocks released by the previous memory manager are reused.
+      EXPECT_EQ(FirstCode, code);
+      EXPECT_EQ(Reserved, Mapper.getReservedSize());
+    }
+  }
+  EXPECT_EQ(Mapper.getReservedSize(), Mapper.getFreeSize());
+}
+
+// Forwards to a PooledMemoryMapper and records the blocks it protects.
+class RecordingMapper final : public SectionMemoryManager::MemoryMapper {
+public:
+  RecordingMapper(PooledMemoryMapper &Pool) : Pool(Pool) {}
+
+  sys::MemoryBlock
+  allocateMappedMemory(SectionMemoryManager::AllocationPurpose Purpose,
+                       size_t NumBytes, const sys::MemoryBlock *const NearBlock,
+                       unsigned Flags, std::error_code &EC) override {
+    return Pool.allocateMappedMemory(Purpose, NumBytes, NearBlock, Flags, EC);
+  }
+
+  std::error_code protectMappedMemory(const sys::MemoryBlock &Block,
+                                      unsigned Flags) override {
+    Protected.push_back(std::make_pair(Block, Flags));
+    return Pool.protectMappedMemory(Block, Flags);
+  }
+
+  std::error_code releaseMappedMemory(sys::MemoryBlock &M) override {
+    return Pool.releaseMappedMemory(M);
+  }
+
+  PooledMemoryMapper &Pool;
+  std::vector<std::pair<sys::MemoryBlock, unsigned>> Protected;
+};
+
+TEST(MCJITMemoryManagerTest, PooledMapReleaseRemap) {
+  const size_t PageSize = sys::Process::getPageSize();
+  PooledMemoryMapper Pool(16 * PageSize);
+  RecordingMapper Mapper(Pool);
+
+  uint8_t *FirstCode = nullptr;
+  for (unsigned Round = 0; Round < 2; ++Round) {
+    Mapper.Protected.clear();
+    std::unique_ptr<SectionMemoryManager> MemMgr(
+        new SectionMemoryManager(&Mapper));
+
+    // The first section fills all but the last few bytes of a two page
+    // block, so the second one gets a block of its own, right after it.
+    uint8_t *code1 = MemMgr->allocateCodeSection(2 * PageSize - 32, 0, 1, "");
+    uint8_t *code2 = MemMgr->allocateCodeSection(PageSize, 0, 2, "");
+    ASSERT_NE((uint8_t*)nullptr, code1);
+    ASSERT_NE((uint8_t*)nullptr, code2);
+    EXPECT_EQ(code1 + 2 * PageSize, code2);
+    code1[0] = 1;
+    code2[0] = 2;
+
+    // Released blocks are handed out again, at the same address.
+    if (Round == 0)
+      FirstCode = code1;
+    else
+      EXPECT_EQ(FirstCode, code1);
+
+    // The two pending blocks touch, so they are protected with one call.
+    std::string Error;
+    EXPECT_FALSE(MemMgr->finalizeMemory(&Error));
+    ASSERT_EQ(1u, Mapper.Protected.size());
+    EXPECT_EQ(code1, Mapper.Protected[0].first.base());
+    EXPECT_EQ(2 * PageSize + PageSize, Mapper.Protected[0].first.size());
+    EXPECT_EQ(unsigned(sys::Memory::MF_READ | sys::Memory::MF_EXEC),
+              Mapper.Protected[0].second);
+    EXPECT_EQ(1, code1[0]);
+    EXPECT_EQ(2, code2[0]);
+  }
+  EXPECT_EQ(16 * PageSize, Pool.getReservedSize());
+  EXPECT_EQ(Pool.getReservedSize(), Pool.getFreeSize());
+}
+
 } // Namespace
 
@@ -11,6 +11,7 @@
 #include "llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/ExecutionEngine/Orc/OrcError.h"
 
+#include <mutex>
 #include <set>
 #include <thread>
 
@@ -773,6 +774,44 @@ TEST_F(CoreAPIsStandardTest, TestLookupWithThreadedMaterialization) {
 #endif
 }
 
+TEST_F(CoreAPIsStandardTest, TestLookupWithMaterializationThreads) {
+#if LLVM_ENABLE_THREADS
+
+  ES.setNumMaterializationThreads(2);
+
+  std::mutex ThreadIDsMutex;
+  std::set<std::thread::id> ThreadIDs;
+  auto MakeMU = [&](SymbolStringPtr Name, JITEvaluatedSymbol Sym) {
+    return llvm::make_unique<SimpleMaterializationUnit>(
+        SymbolFlagsMap({{Name, Sym.getFlags()}}),
+        [&, Name, Sym](MaterializationResponsibility R) {
+          {
+            std::lock_guard<std::mutex> Lock(ThreadIDsMutex);
+            ThreadIDs.insert(std::this_thread::get_id());
+          }
+          R.resolve({{Name, Sym}});
+          R.emit();
+        });
+  };
+
+  cantFail(JD.define(MakeMU(Foo, FooSym)));
+  cantFail(JD.define(MakeMU(Bar, BarSym)));
+
+  auto Result =
+      cantFail(ES.lookup(JITDylibSearchList({{&JD, false}}), {Foo, Bar}));
+
+  EXPECT_EQ(Result[Foo].getAddress(), FooSym.getAddress())
+      << "lookup returned an incorrect address for Foo";
+  EXPECT_EQ(Result[Bar].getAddress(), BarSym.getAddress())
+      << "lookup returned an incorrect address for Bar";
+
+  ES.waitForMaterializationThreads();
+  EXPECT_FALSE(ThreadIDs.empty()) << "No units were materialized";
+  EXPECT_FALSE(ThreadIDs.count(std::this_thread::get_id()))
+      << "Units were materialized on the lookup thread";
+#endif
+}
+
 TEST_F(CoreAPIsStandardTest, TestGetRequestedSymbolsAndReplace) {
   // Test that GetRequestedSymbols returns the set of symbols that currently
   // have pending queries, and test that MaterializationResponsibility's
@@ -9,6 +9,8 @@
 #include "llvm/Support/Allocator.h"
 #include "gtest/gtest.h"
 #include <cstdlib>
+#include <cstring>
+#include <vector>
 
 using namespace llvm;
 
@@ -184,4 +186,65 @@ TEST(AllocatorTest, TestBigAlignment) {
   EXPECT_GT(MockSlabAllocator::GetLastSlabSize(), 4096u);
 }
 
+#if !LLVM_ADDRESS_SANITIZER_BUILD && !LLVM_MEMORY_SANITIZER_BUILD
+// Slabs of the sizes BumpPtrAllocator uses are recycled through the pool.
+TEST(AllocatorTest, TestSlabPool) {
+  SlabAllocator Slabs;
+  void *Slab = Slabs.Allocate(4096, 0);
+  memset(Slab, 0x55, 4096);
+  Slabs.Deallocate(Slab, 4096);
+  EXPECT_EQ(Slab, Slabs.Allocate(4096, 0));
+
+  // Pooled slabs are aligned to their size.
+  void *Big = Slabs.Allocate(65536, 0);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(Big) % 65536);
+  memset(Big, 0x55, 65536);
+
+  // Other sizes come from malloc.
+  void *Odd = Slabs.Allocate(5000, 0);
+  memset(Odd, 0x55, 5000);
+  Slabs.Deallocate(Odd, 5000);
+  Slabs.Deallocate(Big, 65536);
+  Slabs.Deallocate(Slab, 4096);
+}
+
+// Chunks of the pool without a slab in use can be returned to the system.
+TEST(AllocatorTest, TestSlabPoolRelease) {
+  // Enough slabs to fill at least one chunk of the pool entirely.
+  const size_t SlabSize = 65536, NumSlabs = 100;
+  SlabAllocator Slabs;
+  // Start from a pool that will not release chunks on its own in between.
+  SlabAllocator::releaseFreeMemory();
+  std::vector<void *> Allocated;
+  for (size_t I = 0; I != NumSlabs; ++I) {
+    Allocated.push_back(Slabs.Allocate(SlabSize, 0));
+    memset(Allocated.back(), 0x55, SlabSize);
+  }
+  for (void *Slab : Allocated)
+    Slabs.Deallocate(Slab, SlabSize);
+  EXPECT_GE(SlabAllocator::releaseFreeMemory(), 2u * 1024 * 1024);
+  EXPECT_EQ(0u, SlabAllocator::releaseFreeMemory());
+
+  // The pool maps new memory as needed afterwards.
+  void *Slab = Slabs.Allocate(SlabSize, 0);
+  memset(Slab, 0x55, SlabSize);
+  Slabs.Deallocate(Slab, SlabSize);
+}
+
+TEST(AllocatorTest, TestSlabPoolReleasesOnItsOwn) {
+  // Free 32MB, far more than the pool keeps around without releasing any.
+  const size_t SlabSize = 65536, NumSlabs = 512;
+  SlabAllocator Slabs;
+  SlabAllocator::releaseFreeMemory();
+  std::vector<void *> Allocated;
+  for (size_t I = 0; I != NumSlabs; ++I) {
+    Allocated.push_back(Slabs.Allocate(SlabSize, 0));
+    memset(Allocated.back(), 0x55, SlabSize);
+  }
+  for (void *Slab : Allocated)
+    Slabs.Deallocate(Slab, SlabSize);
+  EXPECT_LE(SlabAllocator::releaseFreeMemory(), 24u * 1024 * 1024);
+}
+#endif
+
 }  // anonymous namespace
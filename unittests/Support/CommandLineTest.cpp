@@ -18,6 +18,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/StringSaver.h"
 #include "gtest/gtest.h"
+#include <functional>
 #include <fstream>
 #include <stdlib.h>
 #include <string>
@@ -482,6 +483,53 @@ TEST(CommandLineTest, ReparseCommandLineOptions) {
   EXPECT_TRUE(TopLevelOpt);
 }
 
+// An option whose occurrence registers more options, the way -load brings in a
+// plugin that defines its own.
+class LoaderOption : public StackOption<bool> {
+public:
+  template <class... Ts>
+  explicit LoaderOption(std::function<void()> Load, Ts &&... Ms)
+      : StackOption<bool>(std::forward<Ts>(Ms)...), Load(std::move(Load)) {}
+
+private:
+  bool handleOccurrence(unsigned, StringRef, StringRef) override {
+    Load();
+    return false;
+  }
+
+  std::function<void()> Load;
+};
+
+TEST(CommandLineTest, OptionRegisteredDuringParse) {
+  cl::ResetCommandLineParser();
+
+  std::unique_ptr<StackOption<bool>> LateOpt;
+  LoaderOption Loader(
+      [&] { LateOpt.reset(new StackOption<bool>("late-opt")); }, "loader");
+
+  const char *args[] = {"prog", "-loader", "-late-opt"};
+  EXPECT_TRUE(
+      cl::ParseCommandLineOptions(3, args, StringRef(), &llvm::nulls()));
+  ASSERT_TRUE(LateOpt);
+  EXPECT_TRUE(*LateOpt);
+}
+
+TEST(CommandLineTest, LiteralAddedDuringParse) {
+  cl::ResetCommandLineParser();
+
+  enum class Kind { Early, Late };
+  StackOption<Kind> KindOpt(cl::values(clEnumValN(Kind::Early, "early", "")),
+                            cl::init(Kind::Early));
+  LoaderOption Loader(
+      [&] { KindOpt.getParser().addLiteralOption("late", Kind::Late, ""); },
+      "loader");
+
+  const char *args[] = {"prog", "-loader", "-late"};
+  EXPECT_TRUE(
+      cl::ParseCommandLineOptions(3, args, StringRef(), &llvm::nulls()));
+  EXPECT_EQ(Kind::Late, KindOpt);
+}
+
 TEST(CommandLineTest, RemoveFromRegularSubCommand) {
   cl::ResetCommandLineParser();
 
@@ -71,6 +71,65 @@ TEST(CompressionTest, ZlibCRC32) {
       zlib::crc32(StringRef("The quick brown fox jumps over the lazy dog")));
 }
 
+// Text that compresses, but not to nothing.
+static std::string makeBlockInput(size_t Size) {
+  std::string Input;
+  uint32_t State = 1;
+  while (Input.size() < Size) {
+    State = State * 1103515245 + 12345;
+    Input += "word" + std::to_string((State >> 16) % 1000) + " ";
+  }
+  Input.resize(Size);
+  return Input;
+}
+
+static SmallString<0> compressInBlocks(StringRef Input, size_t BlockSize,
+                                       size_t ChunkSize) {
+  SmallString<0> Compressed;
+  zlib::BlockCompressor Compressor(
+      [&](StringRef Data) { Compressed += Data; }, zlib::DefaultCompression,
+      BlockSize);
+  for (size_t I = 0; I < Input.size(); I += ChunkSize)
+    Compressor.write(Input.substr(I, ChunkSize));
+  EXPECT_EQ(Input.size(), Compressor.getInputSize());
+  EXPECT_FALSE(errorToBool(Compressor.finish()));
+  return Compressed;
+}
+
+TEST(CompressionTest, BlockCompressorRoundTrip) {
+  std::string Input = makeBlockInput(1 << 20);
+  SmallString<0> Compressed = compressInBlocks(Input, 64 * 1024, Input.size());
+
+  SmallString<0> Uncompressed;
+  EXPECT_FALSE(
+      errorToBool(zlib::uncompress(Compressed, Uncompressed, Input.size())));
+  EXPECT_EQ(StringRef(Input), Uncompressed);
+
+  // Priming each block with the input before it keeps the ratio close to
+  // that of a single deflate.
+  SmallString<0> Serial;
+  EXPECT_FALSE(errorToBool(zlib::compress(Input, Serial)));
+  EXPECT_LT(Compressed.size(), Serial.size() * 11 / 10);
+}
+
+TEST(CompressionTest, BlockCompressorChunking) {
+  std::string Input = makeBlockInput(300 * 1000);
+  SmallString<0> Whole = compressInBlocks(Input, 16 * 1024, Input.size());
+  for (size_t ChunkSize : {1000, 16 * 1024, 100 * 1000})
+    EXPECT_EQ(Whole, compressInBlocks(Input, 16 * 1024, ChunkSize));
+}
+
+TEST(CompressionTest, BlockCompressorSingleBlock) {
+  for (size_t Size : {0, 13, 1000}) {
+    std::string Input = makeBlockInput(Size);
+    SmallString<0> Expected;
+    EXPECT_FALSE(errorToBool(zlib::compress(Input, Expected)));
+    SmallString<0> Parallel;
+    EXPECT_FALSE(errorToBool(zlib::compressParallel(Input, Parallel)));
+    EXPECT_EQ(Expected, Parallel);
+  }
+}
+
 #endif
 
 }
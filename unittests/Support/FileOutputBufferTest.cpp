@@ -121,4 +121,69 @@ TEST(FileOutputBuffer, Test) {
   // Clean up.
   ASSERT_NO_ERROR(fs::remove(TestDirectory.str()));
 }
+
+TEST(FileOutputBuffer, MappedStream) {
+  SmallString<128> TestDirectory;
+  ASSERT_NO_ERROR(
+      fs::createUniqueDirectory("FileOutputBuffer-test", TestDirectory));
+
+  // Grow the stream well past its initial size, with both small writes that
+  // go through the stream's buffer and large ones that don't.
+  SmallString<128> File1(TestDirectory);
+  File1.append("/file1");
+  std::string Contents;
+  {
+    Expected<std::unique_ptr<raw_mapped_file_ostream>> OSOrErr =
+        raw_mapped_file_ostream::create(File1);
+    ASSERT_NO_ERROR(errorToErrorCode(OSOrErr.takeError()));
+    raw_mapped_file_ostream &OS = **OSOrErr;
+    OS << "HEADER";
+    Contents += "HEADER";
+    std::string Large(100000, 'x');
+    for (unsigned I = 0; I != 20; ++I) {
+      OS << I << ' ';
+      Contents += std::to_string(I) + ' ';
+      OS << Large;
+      Contents += Large;
+    }
+    EXPECT_EQ(Contents.size(), OS.tell());
+    OS.pwrite("header", 6, 0);
+    Contents.replace(0, 6, "header");
+    OS.reserveExtraSpace(1 << 20);
+    OS << "end";
+    Contents += "end";
+    ASSERT_NO_ERROR(errorToErrorCode(OS.commit()));
+  }
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MB = MemoryBuffer::getFile(File1);
+  ASSERT_NO_ERROR(MB.getError());
+  EXPECT_EQ(Contents, (*MB)->getBuffer());
+  ASSERT_NO_ERROR(fs::remove(File1.str()));
+
+  // Nothing is written unless the stream is committed.
+  SmallString<128> File2(TestDirectory);
+  File2.append("/file2");
+  {
+    Expected<std::unique_ptr<raw_mapped_file_ostream>> OSOrErr =
+        raw_mapped_file_ostream::create(File2);
+    ASSERT_NO_ERROR(errorToErrorCode(OSOrErr.takeError()));
+    **OSOrErr << "discarded";
+  }
+  EXPECT_FALSE(fs::exists(Twine(File2)));
+
+  // An empty stream commits an empty file.
+  SmallString<128> File3(TestDirectory);
+  File3.append("/file3");
+  {
+    Expected<std::unique_ptr<raw_mapped_file_ostream>> OSOrErr =
+        raw_mapped_file_ostream::create(File3);
+    ASSERT_NO_ERROR(errorToErrorCode(OSOrErr.takeError()));
+    ASSERT_NO_ERROR(errorToErrorCode((*OSOrErr)->commit()));
+  }
+  uint64_t File3Size;
+  ASSERT_NO_ERROR(fs::file_size(Twine(File3), File3Size));
+  EXPECT_EQ(0ULL, File3Size);
+  ASSERT_NO_ERROR(fs::remove(File3.str()));
+
+  ASSERT_NO_ERROR(fs::remove(TestDirectory.str()));
+}
 } // anonymous namespace
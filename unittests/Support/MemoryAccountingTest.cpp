@@ -0,0 +1,113 @@
+//===- unittests/Support/MemoryAccountingTest.cpp - Accounting tests ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/MemoryAccounting.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Timer.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+const unsigned SCEV = static_cast<unsigned>(MemoryCategory::SCEV);
+const unsigned MC = static_cast<unsigned>(MemoryCategory::MC);
+
+class MemoryAccountingTest : public testing::Test {
+protected:
+  void SetUp() override { detail::MemoryAccountingEnabled = true; }
+  void TearDown() override { detail::MemoryAccountingEnabled = false; }
+};
+
+TEST_F(MemoryAccountingTest, BumpPtrAllocator) {
+  MemoryRegionStart Start = beginMemoryRegion();
+  {
+    BumpPtrAllocator Alloc;
+    Alloc.setMemoryCategory(MemoryCategory::SCEV);
+    Alloc.Allocate(100, 1);
+    Alloc.Allocate(8192, 1);
+  }
+  MemoryUsage Usage = endMemoryRegion(Start);
+  EXPECT_EQ(0, Usage.Net[SCEV]);
+  EXPECT_EQ(4096 + 8192, Usage.Peak[SCEV]);
+  EXPECT_EQ(0, Usage.Peak[MC]);
+}
+
+TEST_F(MemoryAccountingTest, SetCategoryMovesMemory) {
+  BumpPtrAllocator Alloc;
+  Alloc.Allocate(16, 1);
+  MemoryRegionStart Start = beginMemoryRegion();
+  Alloc.setMemoryCategory(MemoryCategory::MC);
+  MemoryUsage Usage = endMemoryRegion(Start);
+  EXPECT_EQ(4096, Usage.Net[MC]);
+
+  // Memory allocated before accounting was enabled is never released from it.
+  detail::MemoryAccountingEnabled = false;
+  BumpPtrAllocator Untracked;
+  Untracked.setMemoryCategory(MemoryCategory::SCEV);
+  Untracked.Allocate(16, 1);
+  detail::MemoryAccountingEnabled = true;
+  Start = beginMemoryRegion();
+  Untracked.Reset();
+  Untracked = BumpPtrAllocator();
+  Usage = endMemoryRegion(Start);
+  EXPECT_EQ(0, Usage.Net[SCEV]);
+}
+
+TEST_F(MemoryAccountingTest, NestedRegions) {
+  BumpPtrAllocator Outer;
+  Outer.setMemoryCategory(MemoryCategory::SCEV);
+  MemoryRegionStart OuterStart = beginMemoryRegion();
+  {
+    BumpPtrAllocator Inner;
+    Inner.setMemoryCategory(MemoryCategory::SCEV);
+    MemoryRegionStart InnerStart = beginMemoryRegion();
+    Inner.Allocate(3 * 4096, 1);
+    MemoryUsage Usage = endMemoryRegion(InnerStart);
+    EXPECT_EQ(3 * 4096, Usage.Net[SCEV]);
+    EXPECT_EQ(3 * 4096, Usage.Peak[SCEV]);
+  }
+  Outer.Allocate(16, 1);
+  MemoryUsage Usage = endMemoryRegion(OuterStart);
+  // The peak of the inner region carries over to the outer one.
+  EXPECT_EQ(4096, Usage.Net[SCEV]);
+  EXPECT_EQ(3 * 4096, Usage.Peak[SCEV]);
+
+  MemoryUsage Sum = Usage;
+  Sum += Usage;
+  EXPECT_EQ(2 * 4096, Sum.Net[SCEV]);
+  EXPECT_EQ(3 * 4096, Sum.Peak[SCEV]);
+}
+
+TEST_F(MemoryAccountingTest, Timer) {
+  TimerGroup TG("group", "Memory accounting test");
+  Timer T("timer", "timer", TG);
+  BumpPtrAllocator Alloc;
+  Alloc.setMemoryCategory(MemoryCategory::MC);
+  T.startTimer();
+  Alloc.Allocate(16, 1);
+  T.stopTimer();
+  T.startTimer();
+  Alloc.Allocate(8192, 1);
+  T.stopTimer();
+  TimeRecord Total = T.getTotalTime();
+  const MemoryUsage &Usage = Total.getMemoryUsage();
+  EXPECT_EQ(4096 + 8192, Usage.Net[MC]);
+  EXPECT_EQ(8192, Usage.Peak[MC]);
+  T.clear();
+}
+
+TEST_F(MemoryAccountingTest, AccountedNodes) {
+  // Whether nodes are accounted is fixed by the first allocation, so only
+  // check that the memory round-trips.
+  void *P = allocateAccounted(24, MemoryCategory::IR);
+  memset(P, 0, 24);
+  deallocateAccounted(P, MemoryCategory::IR);
+}
+
+} // end anonymous namespace
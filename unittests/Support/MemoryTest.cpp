@@ -407,7 +407,8 @@ unsigned MemoryFlags[] = {
                            Memory::MF_READ|Memory::MF_WRITE,
                            Memory::MF_EXEC,
                            Memory::MF_READ|Memory::MF_EXEC,
-                           Memory::MF_READ|Memory::MF_WRITE|Memory::MF_EXEC
+                           Memory::MF_READ|Memory::MF_WRITE|Memory::MF_EXEC,
+                           Memory::MF_READ|Memory::MF_WRITE|Memory::MF_HUGE_PAGE
                          };
 
 INSTANTIATE_TEST_CASE_P(AllocationTests,
@@ -12,9 +12,20 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Parallel.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/ThreadPool.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
+#include <numeric>
 #include <random>
+#include <thread>
+
+#if LLVM_ON_UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 uint32_t array[1024 * 1024];
 
@@ -49,4 +60,140 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, nested_for_each) {
+  // Every outer task waits for an inner parallel loop, which used to hang
+  // once all workers were blocked waiting.
+  std::vector<uint32_t> Counts(64 * 64);
+  for_each_n(parallel::par, 0, 64, [&](size_t I) {
+    for_each_n(parallel::par, 0, 64, [&](size_t J) { ++Counts[I * 64 + J]; });
+  });
+  ASSERT_TRUE(llvm::all_of(Counts, [](uint32_t C) { return C == 1; }));
+}
+
+TEST(Parallel, sync_runs_only_its_own_tasks) {
+  // A loop waiting for its inner loop may run the inner loop's tasks, but not
+  // the outer loop's other iterations, which would nest on its stack.
+  static LLVM_THREAD_LOCAL unsigned Depth = 0;
+  std::atomic<unsigned> MaxDepth{0};
+  for_each_n(parallel::par, 0, 256, [&](size_t I) {
+    unsigned D = ++Depth;
+    unsigned Max = MaxDepth;
+    while (D > Max && !MaxDepth.compare_exchange_weak(Max, D))
+      ;
+    for_each_n(parallel::par, 0, 64, [&](size_t J) {});
+    --Depth;
+  });
+  ASSERT_EQ(1u, MaxDepth.load());
+}
+
+TEST(Parallel, for_each_in_thread_pool) {
+  std::vector<uint32_t> Counts(8 * 1024);
+  ThreadPool Pool(2);
+  for (size_t I = 0; I < 8; ++I)
+    Pool.async([&, I] {
+      for_each_n(parallel::par, 0, 1024,
+                 [&](size_t J) { ++Counts[I * 1024 + J]; });
+    });
+  Pool.wait();
+  ASSERT_TRUE(llvm::all_of(Counts, [](uint32_t C) { return C == 1; }));
+}
+
+TEST(Parallel, transform_reduce) {
+  // Sum the lengths of strings and check the result is the same as
+  // sequentially, including for inputs that don't split into equal chunks.
+  std::vector<std::string> Strings;
+  for (unsigned I = 0; I < 5000; ++I)
+    Strings.push_back(std::string(I % 17, 'x'));
+  for (size_t N : {0, 1, 1023, 1024, 1025, 5000}) {
+    auto Len = [](const std::string &S) { return S.size(); };
+    size_t Expected = transform_reduce(parallel::seq, Strings.begin(),
+                                       Strings.begin() + N, size_t(0),
+                                       std::plus<size_t>(), Len);
+    size_t Actual = transform_reduce(parallel::par, Strings.begin(),
+                                     Strings.begin() + N, size_t(0),
+                                     std::plus<size_t>(), Len);
+    ASSERT_EQ(Expected, Actual);
+  }
+
+  // Concatenation is associative but not commutative.
+  std::string Concat = transform_reduce(
+      parallel::par, Strings.begin(), Strings.end(), std::string(),
+      [](std::string A, const std::string &B) { return A + B; },
+      [](const std::string &S) { return S + "|"; });
+  std::string Expected;
+  for (const std::string &S : Strings)
+    Expected += S + "|";
+  ASSERT_EQ(Expected, Concat);
+}
+
+TEST(Parallel, inclusive_scan) {
+  for (size_t N : {0, 1, 7, 1024, 3000}) {
+    std::vector<uint64_t> In(N);
+    for (size_t I = 0; I < N; ++I)
+      In[I] = I * 3 + 1;
+    std::vector<uint64_t> Expected(N), Out(N);
+    std::partial_sum(In.begin(), In.end(), Expected.begin());
+    auto OutEnd = inclusive_scan(parallel::par, In.begin(), In.end(),
+                                 Out.begin(), std::plus<uint64_t>());
+    ASSERT_TRUE(OutEnd == Out.end());
+    ASSERT_EQ(Expected, Out);
+
+    // In place.
+    inclusive_scan(parallel::par, In.begin(), In.end(), In.begin(),
+                   std::plus<uint64_t>());
+    ASSERT_EQ(Expected, In);
+  }
+}
+
+TEST(Parallel, transform_ordered) {
+  std::vector<unsigned> In(3000);
+  std::iota(In.begin(), In.end(), 0);
+  std::vector<std::string> Out;
+  transform_ordered(parallel::par, In.begin(), In.end(),
+                    [](unsigned I) { return std::to_string(I); },
+                    [&](std::string S) { Out.push_back(std::move(S)); });
+  ASSERT_EQ(In.size(), Out.size());
+  for (unsigned I = 0; I < In.size(); ++I)
+    ASSERT_EQ(std::to_string(I), Out[I]);
+}
+
+TEST(Parallel, small_inputs_run_on_calling_thread) {
+  // Inputs too small to split into chunks are not handed to the workers.
+  std::vector<unsigned> In(100);
+  std::iota(In.begin(), In.end(), 0);
+  std::thread::id Caller = std::this_thread::get_id();
+  std::atomic<unsigned> Elsewhere(0);
+  auto Check = [&](unsigned I) {
+    if (std::this_thread::get_id() != Caller)
+      ++Elsewhere;
+    return I;
+  };
+  transform_reduce(parallel::par, In.begin(), In.end(), 0u,
+                   std::plus<unsigned>(), Check);
+  transform_ordered(parallel::par, In.begin(), In.end(), Check,
+                    [](unsigned) {});
+  ASSERT_EQ(0u, Elsewhere);
+}
+
+#if LLVM_ON_UNIX
+TEST(Parallel, exit_in_forked_child) {
+  // Start the default executor's workers, which a forked child does not get.
+  std::vector<uint32_t> Counts(1024);
+  for_each_n(parallel::par, 0, 1024, [&](size_t I) { ++Counts[I]; });
+
+  pid_t Child = fork();
+  ASSERT_NE(-1, Child);
+  if (Child == 0) {
+    // Run the static destructors. Stopping the workers would hang here; let
+    // the alarm turn that into a failure.
+    alarm(30);
+    exit(0);
+  }
+  int Status;
+  ASSERT_EQ(Child, waitpid(Child, &Status, 0));
+  ASSERT_TRUE(WIFEXITED(Status));
+  ASSERT_EQ(0, WEXITSTATUS(Status));
+}
+#endif
+
 #endif
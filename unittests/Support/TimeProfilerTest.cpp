@@ -0,0 +1,122 @@
+//===- unittests/TimeProfilerTest.cpp - Time trace profiler tests ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/JSON.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+using namespace llvm;
+
+namespace {
+
+// Returns the trace events with the given name.
+std::vector<const json::Object *> findEvents(const json::Value &Trace,
+                                             StringRef Name) {
+  std::vector<const json::Object *> Result;
+  const json::Array *Events = Trace.getAsObject()->getArray("traceEvents");
+  for (const json::Value &E : *Events)
+    if (E.getAsObject()->getString("name") == Name)
+      Result.push_back(E.getAsObject());
+  return Result;
+}
+
+json::Value writeTrace() {
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  timeTraceProfilerWrite(OS);
+  Expected<json::Value> Trace = json::parse(OS.str());
+  EXPECT_TRUE(!!Trace);
+  return Trace ? std::move(*Trace) : json::Value(nullptr);
+}
+
+TEST(TimeProfiler, Disabled) {
+  EXPECT_FALSE(timeTraceProfilerEnabled());
+  // Scopes are no-ops when the profiler is not initialized.
+  TimeTraceScope Scope("Outer", "detail");
+  timeTraceProfilerBegin("Inner", "detail");
+  timeTraceProfilerEnd();
+}
+
+TEST(TimeProfiler, NestedScopes) {
+  timeTraceProfilerInitialize(/*TimeTraceGranularity=*/0);
+  ASSERT_TRUE(timeTraceProfilerEnabled());
+  {
+    TimeTraceScope Outer("Outer", "a");
+    for (int I = 0; I < 3; ++I) {
+      TimeTraceScope Inner("Inner", [&]() { return std::to_string(I); });
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  json::Value Trace = writeTrace();
+  timeTraceProfilerCleanup();
+  EXPECT_FALSE(timeTraceProfilerEnabled());
+
+  auto Outer = findEvents(Trace, "Outer");
+  ASSERT_EQ(1u, Outer.size());
+  EXPECT_EQ(StringRef("a"),
+            *Outer[0]->getObject("args")->getString("detail"));
+  auto Inner = findEvents(Trace, "Inner");
+  ASSERT_EQ(3u, Inner.size());
+  for (const json::Object *E : Inner) {
+    EXPECT_GE(*E->getInteger("ts"), *Outer[0]->getInteger("ts"));
+    EXPECT_LE(*E->getInteger("ts") + *E->getInteger("dur"),
+              *Outer[0]->getInteger("ts") + *Outer[0]->getInteger("dur"));
+  }
+
+  auto Total = findEvents(Trace, "Total Inner");
+  ASSERT_EQ(1u, Total.size());
+  EXPECT_EQ(3, *Total[0]->getObject("args")->getInteger("count"));
+}
+
+TEST(TimeProfiler, Granularity) {
+  timeTraceProfilerInitialize(/*TimeTraceGranularity=*/1000000);
+  { TimeTraceScope Short("Short", StringRef()); }
+  json::Value Trace = writeTrace();
+  timeTraceProfilerCleanup();
+
+  // The section itself is dropped, but it still counts towards the totals.
+  EXPECT_TRUE(findEvents(Trace, "Short").empty());
+  EXPECT_EQ(1u, findEvents(Trace, "Total Short").size());
+}
+
+TEST(TimeProfiler, ZeroGranularity) {
+  // A granularity of 0 keeps sections that took less than a microsecond.
+  timeTraceProfilerInitialize(/*TimeTraceGranularity=*/0);
+  { TimeTraceScope Empty("Empty", StringRef()); }
+  json::Value Trace = writeTrace();
+  timeTraceProfilerCleanup();
+
+  EXPECT_EQ(1u, findEvents(Trace, "Empty").size());
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(TimeProfiler, Threads) {
+  timeTraceProfilerInitialize(/*TimeTraceGranularity=*/0);
+  {
+    TimeTraceScope Main("Main", StringRef());
+    std::thread T([]() {
+      TimeTraceScope Worker("Worker", StringRef());
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    T.join();
+  }
+  json::Value Trace = writeTrace();
+  timeTraceProfilerCleanup();
+
+  auto Main = findEvents(Trace, "Main");
+  auto Worker = findEvents(Trace, "Worker");
+  ASSERT_EQ(1u, Main.size());
+  ASSERT_EQ(1u, Worker.size());
+  EXPECT_NE(*Main[0]->getInteger("tid"), *Worker[0]->getInteger("tid"));
+}
+#endif
+
+} // end anonymous namespace